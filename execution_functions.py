@@ -1,8 +1,9 @@
 import json
 import subprocess
 import sys
+import threading
 from pathlib import Path
-from typing import Dict, List
+from typing import Dict, Iterator, List, Optional
 
 
 def _run_command(command: List[str]) -> Dict:
@@ -63,6 +64,138 @@ def _run_command(command: List[str]) -> Dict:
         ) from e
 
 
+def stream_records(arguments: List[str]) -> Iterator[Dict]:
+    """
+    Run the executable in NDJSON mode and yield its records lazily, as the
+    algorithms finish: first the problem record, then one record per solution,
+    then the memory record.
+
+    Args:
+        arguments: Command line arguments after the executable, e.g.
+            ["bipartite", "1000", "0.01", "--graph=omit"]
+
+    Yields:
+        Dictionaries with a "record" field, "problem", "solution" or "memory",
+        or "error" as the last one of a failed run
+
+    Raises:
+        FileNotFoundError: If executable doesn't exist
+        RuntimeError: If command fails with non-zero return code
+    """
+    executable_path = _get_executable_path()
+    if not executable_path.exists():
+        raise FileNotFoundError(
+            f"Executable not found at {executable_path}. "
+            "Please build the project first with 'cd build && cmake .. && make'"
+        )
+    process = subprocess.Popen(
+        [str(executable_path)] + arguments + ["--format=ndjson"],
+        stdout=subprocess.PIPE,
+        stderr=sys.stderr,
+        text=True,
+    )
+    for line in process.stdout:
+        if line.strip():
+            yield json.loads(line)
+    if process.wait() != 0:
+        raise RuntimeError(
+            f"Command failed with return code {process.returncode}.\n"
+            "Check stderr output above for details."
+        )
+
+
+def run_batch(
+    jobs: List[List[str]], workers: int = 1, time_limit: Optional[float] = None
+) -> Iterator[Dict]:
+    """
+    Run many jobs in one process of the executable and yield their results
+    lazily, in job order; saves the process startup of one run per job.
+
+    Args:
+        jobs: Command lines without the executable, one per job, e.g.
+            [["bipartite", "100", "0.05", "7", "1", "--graph=omit"]]; the jobs
+            are independent and may run in any order
+        workers: Jobs run in parallel (default: 1)
+        time_limit: Seconds for the whole batch, after which the running jobs
+            are cancelled and the rest are skipped (default: none)
+
+    Yields:
+        The JSON output of each job, or {"error": message} if it failed
+
+    Raises:
+        FileNotFoundError: If executable doesn't exist
+        RuntimeError: If command fails with non-zero return code
+    """
+    executable_path = _get_executable_path()
+    if not executable_path.exists():
+        raise FileNotFoundError(
+            f"Executable not found at {executable_path}. "
+            "Please build the project first with 'cd build && cmake .. && make'"
+        )
+    command = [str(executable_path), "batch", f"--jobs={workers}"]
+    if time_limit is not None:
+        command.append(f"--batch-time-limit={time_limit}")
+    process = subprocess.Popen(
+        command,
+        stdin=subprocess.PIPE,
+        stdout=subprocess.PIPE,
+        stderr=sys.stderr,
+        text=True,
+    )
+
+    # feed the jobs from another thread, so that a full stdout pipe can't
+    # block the writes
+    def write_jobs():
+        with process.stdin:
+            for job in jobs:
+                process.stdin.write(" ".join(job) + "\n")
+
+    writer = threading.Thread(target=write_jobs)
+    writer.start()
+    for line in process.stdout:
+        yield json.loads(line)
+    writer.join()
+    if process.wait() != 0:
+        raise RuntimeError(
+            f"Command failed with return code {process.returncode}.\n"
+            "Check stderr output above for details."
+        )
+
+
+def _options(
+    threads: int,
+    sampling: str = "percandidate",
+    generator_threads: int = 0,
+    graph: str = "inline",
+    max_weight: int = 0,
+    order: str = "index",
+    search: str = "exhaustive",
+    component_threads: int = 0,
+    kernelize: bool = False,
+) -> List[str]:
+    """Command line options shared by all the run_* helpers."""
+    options = []
+    if threads > 1:
+        options.append(f"--threads={threads}")
+    if sampling != "percandidate":
+        options.append(f"--sampling={sampling}")
+    if generator_threads > 0:
+        options.append(f"--generator-threads={generator_threads}")
+    if graph != "inline":
+        options.append(f"--graph={graph}")
+    if max_weight > 0:
+        options.append(f"--max-weight={max_weight}")
+    if order != "index":
+        options.append(f"--order={order}")
+    if search != "exhaustive":
+        options.append(f"--search={search}")
+    if component_threads > 0:
+        options.append(f"--component-threads={component_threads}")
+    if kernelize:
+        options.append("--kernelize")
+    return options
+
+
 def _get_executable_path() -> Path:
     """Get the path to the matroid_intersection executable."""
     project_root = Path(__file__).parent
@@ -70,7 +203,19 @@ def _get_executable_path() -> Path:
 
 
 def run_bipartite_matching(
-    n: int, p: float, seed: int = 42, time_limit: int = 10
+    n: int,
+    p: float,
+    seed: int = 42,
+    time_limit: float = 10,
+    threads: int = 1,
+    sampling: str = "percandidate",
+    generator_threads: int = 0,
+    graph: str = "inline",
+    max_weight: int = 0,
+    order: str = "index",
+    search: str = "exhaustive",
+    component_threads: int = 0,
+    kernelize: bool = False,
 ) -> Dict:
     """
     Run bipartite matching algorithm.
@@ -79,7 +224,36 @@ def run_bipartite_matching(
         n: Number of vertices
         p: Edge probability
         seed: Random seed (default: 42)
-        time_limit: Time limit in seconds (default: 10)
+        time_limit: Time limit in seconds, fractions allowed (default: 10)
+        threads: Multi-start local search threads; 1 runs the single
+            deterministic local search (default: 1)
+        sampling: "percandidate" draws once per candidate edge, "geometric"
+            skips to the next kept edge, for large sparse instances; both are
+            reproducible under the seed (default: "percandidate")
+        generator_threads: 0 generates the graph from one sequential random
+            stream; N >= 1 uses counter-based streams on N threads, giving the
+            same graph for every N (default: 0)
+        graph: "inline" puts the edges in the output under "graph", "omit"
+            leaves them out (default: "inline")
+        max_weight: W >= 1 gives the elements random integer weights in
+            [1, W], drawn from the seed, and adds the "weightedbaseline" and
+            "weightedlocalsearch" solutions; every solution then has its
+            "weight" (default: 0, unweighted)
+        order: Element order of the baseline scan: "index" as generated,
+            "mindegree", "random" (shuffled by the seed) or "fewestconflicts"
+            (default: "index")
+        search: "exhaustive" enumerates the local search exchanges,
+            "sampling" samples them at random instead ("samplingsearch", with
+            its samples per second) and "both" runs the two at the same time
+            limit (default: "exhaustive")
+        component_threads: N >= 1 also solves the connected components as
+            separate problems on N threads, adding the merged
+            "componentbaseline" and "componentlocalsearch" solutions
+            (default: 0, off)
+        kernelize: Also solves the kernel of the matching under safe
+            reduction rules, adding the "kernelbaseline" and
+            "kernellocalsearch" solutions in the original edge indices
+            (default: False)
 
     Returns:
         Dictionary containing the JSON output from the algorithm
@@ -92,11 +266,35 @@ def run_bipartite_matching(
         str(p),
         str(seed),
         str(time_limit),
-    ]
+    ] + _options(
+        threads,
+        sampling,
+        generator_threads,
+        graph,
+        max_weight,
+        order,
+        search,
+        component_threads,
+        kernelize,
+    )
     return _run_command(command)
 
 
-def run_3d_matching(n: int, p: float, seed: int = 42, time_limit: int = 10) -> Dict:
+def run_3d_matching(
+    n: int,
+    p: float,
+    seed: int = 42,
+    time_limit: float = 10,
+    threads: int = 1,
+    sampling: str = "percandidate",
+    generator_threads: int = 0,
+    graph: str = "inline",
+    max_weight: int = 0,
+    order: str = "index",
+    search: str = "exhaustive",
+    component_threads: int = 0,
+    kernelize: bool = False,
+) -> Dict:
     """
     Run 3D matching algorithm.
 
@@ -104,7 +302,36 @@ def run_3d_matching(n: int, p: float, seed: int = 42, time_limit: int = 10) -> D
         n: Number of vertices
         p: Hyperedge probability
         seed: Random seed (default: 42)
-        time_limit: Time limit in seconds (default: 10)
+        time_limit: Time limit in seconds, fractions allowed (default: 10)
+        threads: Multi-start local search threads; 1 runs the single
+            deterministic local search (default: 1)
+        sampling: "percandidate" draws once per candidate edge, "geometric"
+            skips to the next kept edge, for large sparse instances; both are
+            reproducible under the seed (default: "percandidate")
+        generator_threads: 0 generates the graph from one sequential random
+            stream; N >= 1 uses counter-based streams on N threads, giving the
+            same graph for every N (default: 0)
+        graph: "inline" puts the edges in the output under "graph", "omit"
+            leaves them out (default: "inline")
+        max_weight: W >= 1 gives the elements random integer weights in
+            [1, W], drawn from the seed, and adds the "weightedbaseline" and
+            "weightedlocalsearch" solutions; every solution then has its
+            "weight" (default: 0, unweighted)
+        order: Element order of the baseline scan: "index" as generated,
+            "mindegree", "random" (shuffled by the seed) or "fewestconflicts"
+            (default: "index")
+        search: "exhaustive" enumerates the local search exchanges,
+            "sampling" samples them at random instead ("samplingsearch", with
+            its samples per second) and "both" runs the two at the same time
+            limit (default: "exhaustive")
+        component_threads: N >= 1 also solves the connected components as
+            separate problems on N threads, adding the merged
+            "componentbaseline" and "componentlocalsearch" solutions
+            (default: 0, off)
+        kernelize: Also solves the kernel of the matching under safe
+            reduction rules, adding the "kernelbaseline" and
+            "kernellocalsearch" solutions in the original edge indices
+            (default: False)
 
     Returns:
         Dictionary containing the JSON output from the algorithm
@@ -117,7 +344,17 @@ def run_3d_matching(n: int, p: float, seed: int = 42, time_limit: int = 10) -> D
         str(p),
         str(seed),
         str(time_limit),
-    ]
+    ] + _options(
+        threads,
+        sampling,
+        generator_threads,
+        graph,
+        max_weight,
+        order,
+        search,
+        component_threads,
+        kernelize,
+    )
     return _run_command(command)
 
 
@@ -126,7 +363,15 @@ def run_hamiltonian(
     p: float,
     min_hamiltonian_path_length: int = 0,
     seed: int = 42,
-    time_limit: int = 10,
+    time_limit: float = 10,
+    threads: int = 1,
+    sampling: str = "percandidate",
+    generator_threads: int = 0,
+    graph: str = "inline",
+    max_weight: int = 0,
+    order: str = "index",
+    search: str = "exhaustive",
+    component_threads: int = 0,
 ) -> Dict:
     """
     Run Hamiltonian path algorithm.
@@ -136,7 +381,32 @@ def run_hamiltonian(
         p: Edge probability
         min_hamiltonian_path_length: Minimum Hamiltonian path length (default: 0)
         seed: Random seed (default: 42)
-        time_limit: Time limit in seconds (default: 10)
+        time_limit: Time limit in seconds, fractions allowed (default: 10)
+        threads: Multi-start local search threads; 1 runs the single
+            deterministic local search (default: 1)
+        sampling: "percandidate" draws once per candidate edge, "geometric"
+            skips to the next kept edge, for large sparse instances; both are
+            reproducible under the seed (default: "percandidate")
+        generator_threads: 0 generates the graph from one sequential random
+            stream; N >= 1 uses counter-based streams on N threads, giving the
+            same graph for every N (default: 0)
+        graph: "inline" puts the edges in the output under "graph", "omit"
+            leaves them out (default: "inline")
+        max_weight: W >= 1 gives the elements random integer weights in
+            [1, W], drawn from the seed, and adds the "weightedbaseline" and
+            "weightedlocalsearch" solutions; every solution then has its
+            "weight" (default: 0, unweighted)
+        order: Element order of the baseline scan: "index" as generated,
+            "mindegree", "random" (shuffled by the seed) or "fewestconflicts"
+            (default: "index")
+        search: "exhaustive" enumerates the local search exchanges,
+            "sampling" samples them at random instead ("samplingsearch", with
+            its samples per second) and "both" runs the two at the same time
+            limit (default: "exhaustive")
+        component_threads: N >= 1 also solves the connected components as
+            separate problems on N threads, adding the merged
+            "componentbaseline" and "componentlocalsearch" solutions
+            (default: 0, off)
 
     Returns:
         Dictionary containing the JSON output from the algorithm
@@ -150,5 +420,117 @@ def run_hamiltonian(
         str(min_hamiltonian_path_length),
         str(seed),
         str(time_limit),
-    ]
+    ] + _options(
+        threads,
+        sampling,
+        generator_threads,
+        graph,
+        max_weight,
+        order,
+        search,
+        component_threads,
+    )
+    return _run_command(command)
+
+
+def run_instance(
+    path: str,
+    seed: int = 42,
+    time_limit: float = 10,
+    threads: int = 1,
+    graph: str = "inline",
+    max_weight: int = 0,
+    order: str = "index",
+    search: str = "exhaustive",
+    component_threads: int = 0,
+    kernelize: bool = False,
+) -> Dict:
+    """
+    Run the algorithms of the stored problem on an instance file written by
+    the `save` command, e.g. `matroid_intersection save g.inst bipartite 1000 0.01`.
+
+    Args:
+        path: Instance file
+        seed: Random seed of the multi-start local search (default: 42)
+        time_limit: Time limit in seconds, fractions allowed (default: 10)
+        threads: Multi-start local search threads; 1 runs the single
+            deterministic local search (default: 1)
+        graph: "inline" puts the edges in the output under "graph", "omit"
+            leaves them out and "reference" gives the path under "instance"
+            (default: "inline")
+        max_weight: W >= 1 gives the elements random integer weights in
+            [1, W], drawn from the seed, and adds the "weightedbaseline" and
+            "weightedlocalsearch" solutions; every solution then has its
+            "weight" (default: 0, unweighted)
+        order: Element order of the baseline scan: "index" as generated,
+            "mindegree", "random" (shuffled by the seed) or "fewestconflicts"
+            (default: "index")
+        search: "exhaustive" enumerates the local search exchanges,
+            "sampling" samples them at random instead ("samplingsearch", with
+            its samples per second) and "both" runs the two at the same time
+            limit (default: "exhaustive")
+        component_threads: N >= 1 also solves the connected components as
+            separate problems on N threads, adding the merged
+            "componentbaseline" and "componentlocalsearch" solutions
+            (default: 0, off)
+        kernelize: Also solves the kernel of the matching under safe
+            reduction rules, adding the "kernelbaseline" and
+            "kernellocalsearch" solutions in the original edge indices
+            (default: False)
+
+    Returns:
+        Dictionary containing the JSON output from the algorithm
+    """
+    executable_path = _get_executable_path()
+    command = [
+        str(executable_path),
+        "load",
+        str(path),
+        str(seed),
+        str(time_limit),
+    ] + _options(
+        threads,
+        graph=graph,
+        max_weight=max_weight,
+        order=order,
+        search=search,
+        component_threads=component_threads,
+        kernelize=kernelize,
+    )
     return _run_command(command)
+
+
+def local_search_trace(result: Dict, thread: Optional[int] = None) -> List[Dict]:
+    """
+    The improvements of the local search of a run, one row per improving
+    exchange of the steps s >= 1 (step 0 only ends at the first entry of the
+    solution's "stepSeconds"), e.g. to plot the solution size over time with
+    pandas.DataFrame(local_search_trace(result)).
+
+    Args:
+        result: The JSON output of a run
+        thread: With --threads=N, the multi-start thread whose trace to
+            return (default: the one with the largest solution)
+
+    Returns:
+        Rows with "seconds" (since the local search started), "step",
+        "removals", "insertions", "solutionSize" and "candidateChecks" (the
+        insertion candidates queried so far); empty if the run has no trace
+    """
+    trace = None
+    for solution in result.get("solutions", []):
+        statistics = solution.get("statistics") or {}
+        if "trace" in statistics:
+            trace = statistics["trace"]
+        elif solution["algorithm"] == "multistart":
+            threads = statistics["threads"]
+            if thread is None:
+                thread = max(
+                    range(len(threads)),
+                    key=lambda t: threads[t]["solutionSize"],
+                )
+            trace = threads[thread]["trace"]
+    if trace is None:
+        return []
+    columns = list(trace)
+    return [dict(zip(columns, row)) for row in zip(*trace.values())]
@@ -0,0 +1,80 @@
+#ifndef COMMAND_LINE_OPTIONS_H
+#define COMMAND_LINE_OPTIONS_H
+
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Options given as --name=value anywhere on the command line; all the other
+// arguments are positional, argv[0] included
+struct CommandLineOptions {
+  std::vector<std::string> positional;
+  std::map<std::string, std::string> named;
+
+  CommandLineOptions(int argc, char *argv[])
+      : CommandLineOptions(std::vector<std::string>(argv, argv + argc)) {}
+
+  explicit CommandLineOptions(const std::vector<std::string> &args) {
+    for (size_t i = 0; i < args.size(); i++) {
+      const std::string &arg = args[i];
+      if (i > 0 && arg.rfind("--", 0) == 0) {
+        auto equals = arg.find('=');
+        named[arg.substr(2, equals - 2)] =
+            equals == std::string::npos ? "" : arg.substr(equals + 1);
+      } else {
+        positional.push_back(arg);
+      }
+    }
+  }
+
+  int getInt(const std::string &name, int defaultValue) const {
+    auto it = named.find(name);
+    return it == named.end() ? defaultValue : std::stoi(it->second);
+  }
+
+  double getDouble(const std::string &name, double defaultValue) const {
+    auto it = named.find(name);
+    return it == named.end() ? defaultValue : std::stod(it->second);
+  }
+
+  std::string getString(const std::string &name,
+                        const std::string &defaultValue) const {
+    auto it = named.find(name);
+    return it == named.end() ? defaultValue : it->second;
+  }
+
+  // Comma-separated values, e.g. --n=100,200
+  std::vector<std::string> getList(const std::string &name,
+                                   const std::string &defaultValue) const {
+    std::vector<std::string> values;
+    std::istringstream stream(getString(name, defaultValue));
+    for (std::string value; std::getline(stream, value, ',');) {
+      if (!value.empty()) {
+        values.push_back(value);
+      }
+    }
+    return values;
+  }
+};
+
+// A time limit given in seconds, fractions allowed, e.g. 0.25. At most half
+// the range of the steady clock (about 146 years), so that now() plus the
+// limit can't overflow
+inline std::chrono::milliseconds parseTimeLimit(const std::string &seconds) {
+  double value = std::stod(seconds);
+  double maxMilliseconds =
+      static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                              std::chrono::steady_clock::duration::max())
+                              .count()) /
+      2;
+  if (!(value >= 0) || !(value * 1000 <= maxMilliseconds)) {
+    throw std::invalid_argument("Invalid time limit: " + seconds);
+  }
+  return std::chrono::milliseconds(std::llround(value * 1000));
+}
+
+#endif // COMMAND_LINE_OPTIONS_H
@@ -0,0 +1,103 @@
+#ifndef COMPONENT_DECOMPOSITION_H
+#define COMPONENT_DECOMPOSITION_H
+
+#include "hyperedge_list.h"
+#include "matroid_intersection.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// The matroids of the problems here are defined per vertex (the partition and
+// degree matroids) or per connected component (the graphic matroid), so an
+// independent set of the whole ground set is exactly a union of independent
+// sets of its connected components: those are solved as separate, smaller
+// problems, e.g. concurrently, and their solutions merged.
+struct GraphComponent {
+  // edges->getVertex(i, p) is the vertex of the component's edge i,
+  // renumbered within the component to [0, vertexCount)
+  int vertexCount;
+  std::shared_ptr<const HyperedgeList> edges;
+  std::vector<int> elements; // the original index of each edge, increasing
+};
+
+// How the columns of an edge list are read
+enum class ComponentVertices {
+  PerPartition, // column p holds the vertices of partition p (matchings),
+                // renumbered per partition
+  Shared,       // every column holds the same vertices (a path's (from, to))
+};
+
+// The connected components of the hypergraph, ordered by their smallest
+// element; vertexCount vertices per partition (PerPartition) or in all
+// (Shared). Vertices without edges belong to no component. O(E α(E) + kV).
+std::vector<GraphComponent> decomposeIntoComponents(int vertexCount,
+                                                    const HyperedgeList &edges,
+                                                    ComponentVertices vertices);
+
+// Solves every component with solve(component), which returns an
+// ApproximationSolution of the component's elements, on up to threadCount
+// threads, the largest components first. The merged solution is in the
+// original element indices, sorted; its ratio is the smallest of the
+// components', which bounds the whole, and 1 for no component. Rethrows the
+// first exception of a worker after all of them have finished.
+template <typename Solve>
+ApproximationSolution solveComponents(
+    const std::vector<GraphComponent> &components, int threadCount,
+    const Solve &solve) {
+  int componentCount = static_cast<int>(components.size());
+  std::vector<int> bySize(componentCount);
+  for (int c = 0; c < componentCount; c++) {
+    bySize[c] = c;
+  }
+  std::stable_sort(bySize.begin(), bySize.end(), [&components](int a, int b) {
+    return components[a].elements.size() > components[b].elements.size();
+  });
+
+  std::vector<ApproximationSolution> solutions(componentCount,
+                                               ApproximationSolution(1.0, {}));
+  std::atomic<int> next{0};
+  int workerCount = std::max(1, std::min(threadCount, componentCount));
+  std::vector<std::exception_ptr> errors(workerCount);
+  auto worker = [&](int t) {
+    try {
+      for (int i = next++; i < componentCount; i = next++) {
+        solutions[bySize[i]] = solve(components[bySize[i]]);
+      }
+    } catch (...) {
+      errors[t] = std::current_exception();
+      next = componentCount; // the others stop after their component
+    }
+  };
+  if (workerCount == 1) {
+    worker(0);
+  } else {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < workerCount; t++) {
+      threads.emplace_back(worker, t);
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+  for (const auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  double ratio = 1.0;
+  std::vector<int> merged;
+  for (int c = 0; c < componentCount; c++) {
+    ratio = std::min(ratio, solutions[c].getApproximationRatio());
+    for (int element : solutions[c].getSolution()) {
+      merged.push_back(components[c].elements[element]);
+    }
+  }
+  std::sort(merged.begin(), merged.end());
+  return ApproximationSolution(ratio, std::move(merged));
+}
+
+#endif // COMPONENT_DECOMPOSITION_H
@@ -0,0 +1,56 @@
+#ifndef CONFLICT_INDEX_H
+#define CONFLICT_INDEX_H
+
+#include "hyperedge_list.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Conflict index for partition-matroid problems (matchings in k-partite
+// hypergraphs): for every vertex the elements incident to it, and for every
+// vertex the solution element covering it, maintained on add/remove. The
+// conflicts of an element are the owners of its vertices, at most one per
+// partition. Lets local search enumerate only the elements that may enter
+// after removing a set R: those incident to a vertex freed by R.
+class PartitionConflictIndex {
+public:
+  PartitionConflictIndex(int vertexPerPartitionCount,
+                         std::shared_ptr<const HyperedgeList> edges);
+
+  // Copies share the (immutable) incidence lists and own the owner state
+  PartitionConflictIndex(const PartitionConflictIndex &) = default;
+
+  // Track an element entering or leaving the solution
+  void addElement(int element);
+  void removeElement(int element);
+
+  // Appends the distinct solution elements sharing a vertex with element,
+  // in partition order
+  void appendConflicts(int element, std::vector<int> &conflicts) const;
+
+  // True if no solution element shares a vertex with element
+  bool isFree(int element) const;
+
+  // Appends the elements incident to any vertex of element, element included;
+  // may contain duplicates
+  void appendNeighbours(int element, std::vector<int> &neighbours) const;
+
+  int getGraphRank() const { return static_cast<int>(owner_.size()); }
+
+  // Bytes of the owner state, and of the incidence lists that the copies
+  // share (memory_usage.h)
+  std::size_t getMemoryBytes() const;
+  std::size_t getSharedMemoryBytes() const;
+
+private:
+  struct Incidence {
+    std::shared_ptr<const HyperedgeList> edges;
+    std::vector<const int *> vertexOf;    // [k][E] edge columns
+    std::vector<std::vector<int>> offset; // [k][V + 1] CSR offsets
+    std::vector<std::vector<int>> incident; // [k][E] elements per vertex
+  };
+  std::shared_ptr<const Incidence> incidence_;
+  std::vector<std::vector<int>> owner_; // [k][V] covering element or -1
+};
+
+#endif // CONFLICT_INDEX_H
@@ -0,0 +1,71 @@
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+// When an algorithm has to stop: a point in time and, optionally, a flag
+// another thread sets to cancel it, e.g. a batch runner's watchdog. Polled
+// cooperatively from the algorithms' loops, so expired() is cheap: the
+// flag is one relaxed load, and the clock is read on one call in
+// kClockInterval only. Not thread-safe; every thread polls its own copy.
+class Deadline {
+public:
+  using Clock = std::chrono::steady_clock;
+  static constexpr int kClockInterval = 256;
+
+  // Never expires, unless the flag is given and set
+  explicit Deadline(const std::atomic<bool> *cancelled = nullptr)
+      : Deadline(Clock::time_point::max(), cancelled) {}
+
+  Deadline(Clock::time_point at, const std::atomic<bool> *cancelled = nullptr)
+      : at_(at), cancelled_(cancelled) {}
+
+  // This deadline, or limit from now if that comes first
+  Deadline within(std::chrono::milliseconds limit) const {
+    return Deadline(std::min(at_, Clock::now() + limit), cancelled_);
+  }
+
+  // Whether the time has passed or the flag is set; may answer up to
+  // kClockInterval calls late for the time. Once true, stays true.
+  bool expired() {
+    if (expired_) {
+      return true;
+    }
+    if (cancelled_ && cancelled_->load(std::memory_order_relaxed)) {
+      expired_ = true;
+    } else if (++calls_ >= kClockInterval) {
+      calls_ = 0;
+      expired_ = at_ != Clock::time_point::max() && Clock::now() >= at_;
+    }
+    return expired_;
+  }
+
+  // expired(), reading the clock now, e.g. between two phases
+  bool expiredNow() {
+    calls_ = kClockInterval;
+    return expired();
+  }
+
+  // Whether the flag is set, as opposed to the time being up
+  bool isCancelled() const {
+    return cancelled_ && cancelled_->load(std::memory_order_relaxed);
+  }
+
+private:
+  Clock::time_point at_;
+  const std::atomic<bool> *cancelled_;
+  int calls_ = 0;
+  bool expired_ = false;
+};
+
+// Thrown by the algorithms without a meaningful partial result (the exact
+// ones and the greedy baseline) when their deadline expires
+class DeadlineExceeded : public std::runtime_error {
+public:
+  DeadlineExceeded() : std::runtime_error("Deadline exceeded") {}
+};
+
+#endif // DEADLINE_H
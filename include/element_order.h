@@ -0,0 +1,53 @@
+#ifndef ELEMENT_ORDER_H
+#define ELEMENT_ORDER_H
+
+#include "hyperedge_list.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Orders in which the greedy baseline scans the ground set, as
+// BasicBaselineAlgorithm::setElementOrder takes them. The generators emit the
+// edges sorted, so the index order crowds the greedy solution onto the low
+// vertices; the others look at the graph. They read the edges as partition
+// columns (a Hamiltonian path's as (from, to)), vertexCount vertices in each,
+// and two elements conflict once per partition in which they share a vertex.
+enum class ElementOrdering {
+  Index,           // 0, 1, ...; the order the generators emit
+  MinDegree,       // increasing conflict count, ties by index; O(E + V)
+  Random,          // a shuffle under the seed; O(E)
+  FewestConflicts, // repeatedly the element with the fewest conflicts among
+                   // those not yet taken or blocked, see below
+};
+
+// "index", "mindegree", "random" or "fewestconflicts"; throws
+// std::invalid_argument on anything else
+ElementOrdering parseElementOrdering(const std::string &name);
+
+const char *getElementOrderingName(ElementOrdering ordering);
+
+// The order of the given strategy; seed is only used by Random
+std::vector<int>
+computeElementOrder(ElementOrdering ordering, int vertexCount,
+                    const std::shared_ptr<const HyperedgeList> &edges,
+                    unsigned int seed);
+
+std::vector<int> orderByMinDegree(int vertexCount, const HyperedgeList &edges);
+
+std::vector<int> orderRandomly(int elementCount, unsigned int seed);
+
+// The dynamic min-degree greedy: takes the available element with the
+// fewest conflicts among the available ones, blocks its conflicting ones and
+// updates their neighbours' counts, until none is left; the taken elements
+// come first and the blocked ones after, each in the order it left. The
+// counts only decrease, so they sit in a bucket queue whose minimum only
+// moves down by one per update. Costs O(E + the sum over the vertices of
+// their squared degree), the counts being updated along the incidence lists.
+std::vector<int>
+orderByFewestConflicts(int vertexCount,
+                       const std::shared_ptr<const HyperedgeList> &edges);
+
+// The elements by decreasing weight, ties by index: the weighted greedy
+std::vector<int> orderByDecreasingWeight(const std::vector<double> &weights);
+
+#endif // ELEMENT_ORDER_H
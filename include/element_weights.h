@@ -0,0 +1,42 @@
+#ifndef ELEMENT_WEIGHTS_H
+#define ELEMENT_WEIGHTS_H
+
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// Per-element weights of a ground set (the profits of the edges or
+// hyperedges), shared read-only by a problem, its clones and the algorithms.
+// A problem without weights weighs every element 1, so the weight of a set is
+// its size.
+using ElementWeights = std::shared_ptr<const std::vector<double>>;
+
+// Throws std::invalid_argument unless there is one finite, non-negative
+// weight per element
+inline void checkElementWeights(const std::vector<double> &weights,
+                                int groundSetSize) {
+  if (static_cast<int>(weights.size()) != groundSetSize) {
+    throw std::invalid_argument("Expected one weight per element");
+  }
+  for (double weight : weights) {
+    if (!std::isfinite(weight) || weight < 0) {
+      throw std::invalid_argument("Weights must be finite and non-negative");
+    }
+  }
+}
+
+// Total weight of elements, their count without weights
+inline double getSetWeight(const ElementWeights &weights,
+                           const std::vector<int> &elements) {
+  if (!weights) {
+    return static_cast<double>(elements.size());
+  }
+  double total = 0;
+  for (int element : elements) {
+    total += (*weights)[element];
+  }
+  return total;
+}
+
+#endif // ELEMENT_WEIGHTS_H
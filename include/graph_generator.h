@@ -1,6 +1,8 @@
 #ifndef GRAPH_GENERATOR_H
 #define GRAPH_GENERATOR_H
 
+#include "hyperedge_list.h"
+#include <cstdint>
 #include <random>
 #include <utility>
 #include <vector>
@@ -8,14 +10,29 @@
 // Generate random Erdős-Rényi bipartite graph
 class GraphGenerator {
 public:
-  GraphGenerator(unsigned int seed = std::random_device{}());
+  // How the candidate edges of the random generators are kept with
+  // probability p; both are deterministic under the seed, but draw different
+  // random sequences, so they produce different graphs
+  enum class SamplingMode {
+    PerCandidate,  // one draw per candidate edge; O(candidates)
+    GeometricSkip, // draws the gap to the next kept edge; O(edges kept)
+  };
+
+  // threadCount 0 draws every graph from one sequential std::mt19937 stream.
+  // threadCount >= 1 cuts the candidate edges into fixed blocks, each with
+  // its own counter-based stream keyed by the seed, and samples the blocks
+  // on that many threads: the graphs differ from the sequential ones, but
+  // are the same for every thread count.
+  GraphGenerator(unsigned int seed = std::random_device{}(),
+                 SamplingMode mode = SamplingMode::PerCandidate,
+                 int threadCount = 0);
 
   // Generate random bipartite graph with n vertices on left, m on right,
-  // probability p
-  std::vector<std::pair<int, int>> generateErdosRenyiBipartite(int n, double p);
+  // probability p; edge i is (getVertex(i, 0), getVertex(i, 1))
+  HyperedgeList generateErdosRenyiBipartite(int n, double p);
 
   // Generate random complete bipartite graph
-  std::vector<std::pair<int, int>> generateCompleteBipartite(int n);
+  HyperedgeList generateCompleteBipartite(int n);
 
   // Generate random graph for Hamiltonian path testing
   std::vector<std::pair<int, int>> generateRandomGraph(int n, double p);
@@ -29,9 +46,25 @@ public:
   // n: number of vertices in each partition
   // p: probability of adding a hyperedge connecting one vertex from each
   // partition
-  std::vector<std::vector<int>> generate3DGraph(int n, double p);
+  HyperedgeList generate3DGraph(int n, double p);
+
+  // Integer weights uniform in [1, maxWeight], one per element; drawn from a
+  // counter-based stream keyed by the seed alone, so they don't depend on
+  // the sampling mode, the thread count or the graphs generated before, and
+  // a saved instance loaded with the same seed gets the same weights
+  std::vector<double> generateWeights(int elementCount, int maxWeight);
 
 private:
+  // Calls emit(part, index) for every index of [0, total) kept with
+  // probability p, in increasing order; the indices are split into
+  // consecutive parts, one per thread, returned in order
+  template <typename Part, typename Emit>
+  std::vector<Part> sampleParts(std::int64_t total, double p, Emit emit);
+
+  SamplingMode mode_;
+  int threadCount_;
+  unsigned int seed_;
+  std::uint64_t streamCount_ = 0; // counter-based generations so far
   std::mt19937 rng_;
   std::uniform_real_distribution<double> dist_;
 };
@@ -0,0 +1,60 @@
+#ifndef HYPEREDGE_LIST_H
+#define HYPEREDGE_LIST_H
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Flat structure-of-arrays storage of the edges of a k-partite hypergraph:
+// one contiguous column of vertex indices per partition, so edge i is
+// (getVertex(i, 0), ..., getVertex(i, k - 1)). Immutable once built; shared
+// read-only (std::shared_ptr<const HyperedgeList>) by everything that reads
+// the edges, instead of one heap allocation per edge.
+class HyperedgeList {
+public:
+  // Takes ownership of one column per partition, all of the same length
+  explicit HyperedgeList(std::vector<std::vector<int>> columns);
+
+  // Views columns of size entries owned elsewhere, e.g. a memory-mapped
+  // file, without copying; owner keeps them alive as long as the list
+  HyperedgeList(int size, std::vector<const int *> columns,
+                std::shared_ptr<const void> owner);
+
+  // Converts rows of vertex indices, one row per edge
+  static HyperedgeList fromRows(int rank,
+                                const std::vector<std::vector<int>> &rows);
+
+  // Converts directed edges to their (from, to) columns
+  static HyperedgeList
+  fromPairs(const std::vector<std::pair<int, int>> &edges);
+
+  // Columns are referenced by pointer: moving keeps them valid, copying
+  // would not
+  HyperedgeList(HyperedgeList &&) = default;
+  HyperedgeList &operator=(HyperedgeList &&) = default;
+  HyperedgeList(const HyperedgeList &) = delete;
+  HyperedgeList &operator=(const HyperedgeList &) = delete;
+
+  int getRank() const { return static_cast<int>(columns_.size()); }
+
+  int size() const { return size_; }
+
+  int getVertex(int edge, int partition) const {
+    return columns_[partition][edge];
+  }
+
+  // The vertex in the given partition of every edge, size() entries
+  const int *getColumn(int partition) const { return columns_[partition]; }
+
+  // Bytes of the columns the list owns; a view of external storage owns none
+  std::size_t getMemoryBytes() const;
+
+private:
+  int size_;
+  std::vector<std::vector<int>> ownedColumns_;
+  std::vector<const int *> columns_;
+  std::shared_ptr<const void> owner_; // external storage of columns_, if any
+};
+
+#endif // HYPEREDGE_LIST_H
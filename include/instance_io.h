@@ -0,0 +1,38 @@
+#ifndef INSTANCE_IO_H
+#define INSTANCE_IO_H
+
+#include "element_weights.h"
+#include "hyperedge_list.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Binary instance files: a 64-byte header (magic, version, problem type,
+// rank k, vertex count n, edge count E) followed by k columns of E int32
+// vertex indices in native byte order, column p holding the vertex of every
+// edge in partition p. A Hamiltonian instance stores its directed edges as
+// the columns (from, to).
+enum class InstanceType : std::uint32_t {
+  Bipartite = 1,
+  ThreeDMatching = 2,
+  Hamiltonian = 3,
+};
+
+struct Instance {
+  InstanceType type;
+  // vertices per partition for the matchings, of the graph for Hamiltonian
+  int vertexCount;
+  std::shared_ptr<const HyperedgeList> edges;
+  // null unless given (main's --max-weight); not stored in the files
+  ElementWeights weights = nullptr;
+};
+
+// Writes the instance; throws std::runtime_error if the file can't be written
+void saveInstance(const std::string &path, const Instance &instance);
+
+// Maps the file read-only and returns edges viewing the mapped columns
+// directly (no copy); the mapping lives as long as the edges. Throws
+// std::invalid_argument on a malformed file or out-of-range vertex.
+Instance loadInstance(const std::string &path);
+
+#endif // INSTANCE_IO_H
@@ -0,0 +1,39 @@
+#ifndef KERNELIZATION_H
+#define KERNELIZATION_H
+
+#include "hyperedge_list.h"
+#include <memory>
+#include <vector>
+
+// A matching instance (edges->getVertex(i, p) the vertex of edge i in
+// partition p) reduced by rules that keep some maximum matching:
+//  - of edges with the same vertices, only the first is kept, since any
+//    matching can swap a copy for it;
+//  - an edge whose vertices, all but at most one, have no other edge is
+//    forced: it conflicts with at most one edge of a maximum matching, which
+//    it can replace. For bipartite matching this is every edge at a vertex of
+//    degree 1; for k = 3 a single degree-1 vertex is not enough, as the edge
+//    may block two matched ones.
+// A forced edge's neighbours are dropped, which may force more edges. A
+// maximum matching of the kernel plus the forced edges is a maximum matching
+// of the instance, and a kernel solution within a ratio of the kernel
+// optimum stays within it once the forced edges are added.
+struct MatchingKernel {
+  // the remaining edges, over the same vertices
+  std::shared_ptr<const HyperedgeList> edges;
+  std::vector<int> elements; // original index of each kernel edge, increasing
+  std::vector<int> forced;   // original indices of the forced edges
+  int duplicateCount = 0;    // edges dropped as copies
+  int droppedCount = 0;      // edges dropped as neighbours of forced ones
+
+  // The instance solution of a kernel solution: the forced edges and the
+  // original indices of its elements, sorted
+  std::vector<int> lift(const std::vector<int> &kernelSolution) const;
+};
+
+// Applies the rules until none does, in O(E k log E + the sum of the vertex
+// degrees)
+MatchingKernel kernelizeMatching(int vertexPerPartitionCount,
+                                 const HyperedgeList &edges);
+
+#endif // KERNELIZATION_H
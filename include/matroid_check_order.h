@@ -0,0 +1,136 @@
+#ifndef MATROID_CHECK_ORDER_H
+#define MATROID_CHECK_ORDER_H
+
+#include <algorithm>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+// The order in which a problem asks its matroids an independence query. A
+// query ends at the first rejecting matroid, so asking first the one most
+// likely to reject per unit of query cost saves the calls to the others.
+//
+// The rates come from probes: one query (or batch) in kProbeInterval asks
+// every matroid instead of stopping at the first rejection, since a later
+// matroid only sees the queries the earlier ones accepted. Every
+// kReorderInterval probes the matroids are sorted by (rejections + 1) /
+// (probes + 2) / cost, ties in construction order, and the statistics are
+// halved so that they follow the search as it moves on. The answers never
+// depend on the order.
+class MatroidCheckOrder {
+public:
+  static constexpr std::int64_t kProbeInterval = 1024;
+  static constexpr std::int64_t kReorderInterval = 64;
+
+  MatroidCheckOrder() = default;
+
+  // costs[i] is the relative query cost of matroid i, 1 for a lookup
+  explicit MatroidCheckOrder(std::vector<double> costs)
+      : costs_(std::move(costs)), order_(costs_.size()),
+        statistics_(costs_.size()) {
+    std::iota(order_.begin(), order_.end(), 0);
+  }
+
+  std::size_t size() const { return order_.size(); }
+
+  // Matroid indices in the order they are asked
+  const std::vector<std::size_t> &getOrder() const { return order_; }
+
+  // Whether the order adapts; if not, it is construction order
+  void setAdaptive(bool adaptive) {
+    adaptive_ = adaptive;
+    std::iota(order_.begin(), order_.end(), 0);
+    std::fill(statistics_.begin(), statistics_.end(), Statistics{});
+    queriesSinceProbe_ = 0;
+    probesSinceReorder_ = 0;
+  }
+
+  // Whether every matroid accepts, asking answer(i) for matroid i in order
+  template <typename Answer> bool query(const Answer &answer) {
+    bool probe = beginQuery();
+    bool accepted = true;
+    for (std::size_t i : order_) {
+      bool matroidAccepted = answer(i);
+      if (probe) {
+        statistics_[i].probes++;
+        statistics_[i].rejections += !matroidAccepted;
+      } else if (!matroidAccepted) {
+        return false;
+      }
+      accepted = accepted && matroidAccepted;
+    }
+    if (probe) {
+      endProbe();
+    }
+    return accepted;
+  }
+
+  // Batched query: of the candidates in mask, those every matroid accepts,
+  // where answer(i, queried) are those of queried that matroid i accepts
+  template <typename Answer>
+  std::uint32_t queryBatch(std::uint32_t mask, const Answer &answer) {
+    bool probe = beginQuery(); // a batch probes all its candidates
+    std::uint32_t accepted = mask;
+    for (std::size_t i : order_) {
+      if (probe) {
+        std::uint32_t matroidAccepted = answer(i, mask);
+        statistics_[i].probes += std::bitset<32>(mask).count();
+        statistics_[i].rejections +=
+            std::bitset<32>(mask & ~matroidAccepted).count();
+        accepted &= matroidAccepted;
+      } else if (accepted != 0) {
+        accepted = answer(i, accepted);
+      }
+    }
+    if (probe) {
+      endProbe();
+    }
+    return accepted;
+  }
+
+private:
+  struct Statistics {
+    std::int64_t probes = 0;
+    std::int64_t rejections = 0;
+  };
+
+  // Counts a query or batch; true if it is to be a probe
+  bool beginQuery() {
+    if (!adaptive_ || ++queriesSinceProbe_ < kProbeInterval) {
+      return false;
+    }
+    queriesSinceProbe_ = 0;
+    return true;
+  }
+
+  void endProbe() {
+    if (++probesSinceReorder_ < kReorderInterval) {
+      return;
+    }
+    std::vector<double> score(order_.size());
+    for (std::size_t i = 0; i < order_.size(); i++) {
+      score[i] = (statistics_[i].rejections + 1.0) /
+                 (statistics_[i].probes + 2.0) / costs_[i];
+      statistics_[i].probes /= 2;
+      statistics_[i].rejections /= 2;
+    }
+    std::iota(order_.begin(), order_.end(), 0);
+    std::stable_sort(order_.begin(), order_.end(),
+                     [&score](std::size_t a, std::size_t b) {
+                       return score[a] > score[b];
+                     });
+    probesSinceReorder_ = 0;
+  }
+
+  std::vector<double> costs_;
+  std::vector<std::size_t> order_;
+  std::vector<Statistics> statistics_;
+  std::int64_t queriesSinceProbe_ = 0;
+  std::int64_t probesSinceReorder_ = 0;
+  bool adaptive_ = true;
+};
+
+#endif // MATROID_CHECK_ORDER_H
@@ -1,7 +1,9 @@
 #ifndef MATROID_IMPLEMENTATIONS_H
 #define MATROID_IMPLEMENTATIONS_H
 
+#include "hyperedge_list.h"
 #include "matroid_problem.h"
+#include "static_matroid_problem.h"
 #include <map>
 #include <memory>
 #include <set>
@@ -11,78 +13,231 @@
 // Matching problem: find a matching in a hypergraph
 class MatchingProblem : public MatroidProblem {
 public:
+  // edges->getVertex(i, p) is the vertex of edge i in partition p; the edge
+  // storage is shared, not copied
+  MatchingProblem(int vertexPerPartitionCount,
+                  std::shared_ptr<const HyperedgeList> edges);
+
   // edge_list[i] is the list of vertices in edge i, and groundSetSize is the
   // number of vertices
   MatchingProblem(int graphRank, int vertexPerPartitionCount,
                   const std::vector<std::vector<int>> &edge_list);
 
+  std::unique_ptr<MatroidProblem> clone() const override {
+    return std::make_unique<MatchingProblem>(*this);
+  }
+
   // Get the edges of the matching problem
-  const std::vector<std::vector<int>> &getEdges() const { return edges_; }
+  const HyperedgeList &getEdges() const { return *edges_; }
 
-  int getVertexPerPartitionCount() const { return vertexPerPartitionCount_; }
+  const std::shared_ptr<const HyperedgeList> &getSharedEdges() const {
+    return edges_;
+  }
 
-private:
-  std::vector<std::vector<int>> edges_;
-  int vertexPerPartitionCount_;
+  int getVertexPerPartitionCount() const { return vertexPerPartitionCount_; }
 
   // Correponds to each part of the multipartite graph
-  class PartitionMatroidSet : public MatroidSet {
+  class PartitionMatroidSet final : public MatroidSet {
   public:
-    PartitionMatroidSet(int groundSetSize, int vertexPerPartitionCount,
-                        const std::vector<int> &edge_to_vertex);
+    // reads the vertices of the given partition straight from the shared
+    // edge columns
+    PartitionMatroidSet(int vertexPerPartitionCount,
+                        std::shared_ptr<const HyperedgeList> edges,
+                        int partition);
 
+    std::unique_ptr<MatroidSet> clone() const override {
+      return std::make_unique<PartitionMatroidSet>(*this);
+    }
     bool tryAddElement(int element) override;
+    bool canAdd(int element) const override;
+    bool canExchange(int removed, int added) const override;
+    // two gathers (edge to vertex, vertex to owner) per block of 8 with AVX2
+    std::uint32_t canAddBatch(const int *elements, int count,
+                              std::uint32_t mask) const override;
     void removeElement(int element) override;
+    void restoreElement(int element) override;
+    std::size_t getMemoryBytes() const override {
+      return getVectorBytes(vertex_owner_);
+    }
 
   private:
     int groundSetSize_;           // number of edges in the ground set
     int vertexPerPartitionCount_; // number of vertices in each partition
-    std::vector<int>
-        edge_to_vertex_; // for each edge, the index of the vertex it belongs to
-    std::vector<bool> is_vertex_used_; // true if the vertex is used
-    std::vector<bool> is_edge_used_;   // true if the edge is used
+    std::shared_ptr<const HyperedgeList> edges_; // keeps the column alive
+    // for each edge, the index of the vertex it belongs to
+    const int *edge_to_vertex_;
+    // for each vertex, the edge of the set covering it or -1; an edge is in
+    // the set iff it owns its vertex
+    std::vector<int> vertex_owner_;
   };
+
+private:
+  std::shared_ptr<const HyperedgeList> edges_;
+  int vertexPerPartitionCount_;
 };
 
 class HamiltonianPathProblem : public MatroidProblem {
 public:
-  HamiltonianPathProblem(int groundSetSize, int vertexCount,
-                         const std::vector<std::pair<int, int>> &edges);
+  // Data structure answering the cycle query of the graphic matroid
+  enum class GraphicMatroidBackend {
+    NextChain,  // walks the next_ chain; O(path length), kept as a reference
+    PathForest, // splay tree per path; O(log V) amortized
+  };
+
+  // edges->getVertex(i, 0) and getVertex(i, 1) are the tail and the head of
+  // edge i; the edge storage is shared by the three matroids, not copied
+  HamiltonianPathProblem(
+      int vertexCount, std::shared_ptr<const HyperedgeList> edges,
+      GraphicMatroidBackend backend = GraphicMatroidBackend::PathForest);
+
+  // Converts the (from, to) pairs once, to storage shared as above
+  HamiltonianPathProblem(
+      int groundSetSize, int vertexCount,
+      const std::vector<std::pair<int, int>> &edges,
+      GraphicMatroidBackend backend = GraphicMatroidBackend::PathForest);
+
+  std::unique_ptr<MatroidProblem> clone() const override {
+    return std::make_unique<HamiltonianPathProblem>(*this);
+  }
+
+  // The edges as (from, to) columns
+  const HyperedgeList &getEdges() const { return *edges_; }
 
-  const std::vector<std::pair<int, int>> &getEdges() const { return edges_; }
+  const std::shared_ptr<const HyperedgeList> &getSharedEdges() const {
+    return edges_;
+  }
 
   // using single class for both incoming and outgoing edges because they are
   // symmetric
-  class SingleIncomingEdgeMatroidSet : public MatroidSet {
+  class SingleIncomingEdgeMatroidSet final : public MatroidSet {
   public:
-    SingleIncomingEdgeMatroidSet(int groundSetSize, int vertexCount,
-                                 const std::vector<std::pair<int, int>> &edges,
+    // reads the head (is_incoming) or tail column of the shared edges
+    SingleIncomingEdgeMatroidSet(int vertexCount,
+                                 std::shared_ptr<const HyperedgeList> edges,
                                  bool is_incoming);
+    std::unique_ptr<MatroidSet> clone() const override {
+      return std::make_unique<SingleIncomingEdgeMatroidSet>(*this);
+    }
     bool tryAddElement(int element) override;
+    bool canAdd(int element) const override;
+    bool canExchange(int removed, int added) const override;
     void removeElement(int element) override;
+    void restoreElement(int element) override;
+    std::size_t getMemoryBytes() const override {
+      return getVectorBytes(is_vertex_used_);
+    }
 
   private:
     int vertexCount_;
     int groundSetSize_;
-    std::vector<int> edge_to_;         // [E]
-    std::vector<bool> is_vertex_used_; // [V]
+    std::shared_ptr<const HyperedgeList> edges_; // keeps the column alive
+    const int *edge_to_;                         // [E] the column read
+    std::vector<bool> is_vertex_used_;           // [V]
   };
-  class GraphicMatroidSet : public MatroidSet {
+  class GraphicMatroidSet final : public MatroidSet {
   public:
-    GraphicMatroidSet(int groundSetSize, int vertexCount,
-                      const std::vector<std::pair<int, int>> &edges);
+    GraphicMatroidSet(int vertexCount,
+                      std::shared_ptr<const HyperedgeList> edges);
+    std::unique_ptr<MatroidSet> clone() const override {
+      return std::make_unique<GraphicMatroidSet>(*this);
+    }
     bool tryAddElement(int element) override;
+    bool canAdd(int element) const override;
+    bool canExchange(int removed, int added) const override;
     void removeElement(int element) override;
+    void restoreElement(int element) override;
+    // a walk along the path, several lookups even when it is short
+    double getQueryCost() const override { return 8.0; }
+    std::size_t getMemoryBytes() const override {
+      return getVectorBytes(next_);
+    }
 
   private:
     int vertexCount_;
     int groundSetSize_;
-    std::vector<int> next_;                  // [V]
-    std::vector<std::pair<int, int>> edges_; // [E]
+    std::shared_ptr<const HyperedgeList> edges_; // keeps the columns alive
+    const int *from_;                            // [E] tails
+    const int *to_;                              // [E] heads
+    std::vector<int> next_;                      // [V]
+  };
+  // Same matroid as GraphicMatroidSet; relies on the degree matroids being
+  // checked first, so every component of the current set is a directed path.
+  // Each path is kept as a splay tree ordered along the path, so the cycle
+  // check (are the tail and the head on the same path) and the link/cut
+  // updates cost O(log V) amortized instead of O(path length).
+  class PathForestGraphicMatroidSet final : public MatroidSet {
+  public:
+    PathForestGraphicMatroidSet(int vertexCount,
+                                std::shared_ptr<const HyperedgeList> edges);
+    std::unique_ptr<MatroidSet> clone() const override {
+      return std::make_unique<PathForestGraphicMatroidSet>(*this);
+    }
+    bool tryAddElement(int element) override;
+    bool canAdd(int element) const override;
+    bool canExchange(int removed, int added) const override;
+    void removeElement(int element) override;
+    void restoreElement(int element) override;
+    // two splays
+    double getQueryCost() const override { return 4.0; }
+    std::size_t getMemoryBytes() const override {
+      return getVectorBytes(next_) + getVectorBytes(parent_) +
+             getVectorBytes(left_) + getVectorBytes(right_);
+    }
+
+  private:
+    // splaying only rebalances the trees, so the queries stay const
+    void rotate(int x) const;
+    void splay(int x) const;
+    bool isSamePath(int u, int v) const;
+    // whether v comes no later than x on the path containing both
+    bool isUpTo(int v, int x) const;
+    // joins the path ending at from and the one starting at to
+    void link(int from, int to);
+
+    int vertexCount_;
+    int groundSetSize_;
+    std::shared_ptr<const HyperedgeList> edges_; // keeps the columns alive
+    const int *from_;                            // [E] tails
+    const int *to_;                              // [E] heads
+    std::vector<int> next_;                      // [V]
+    mutable std::vector<int> parent_;            // [V], -1 for a splay root
+    mutable std::vector<int> left_;              // [V]
+    mutable std::vector<int> right_;             // [V]
   };
 
 private:
-  std::vector<std::pair<int, int>> edges_;
+  std::shared_ptr<const HyperedgeList> edges_;
 };
 
+// Compile-time composed equivalents of the problems above, for the
+// algorithms' hot paths; the virtual classes stay for experimenting with new
+// matroids
+using StaticBipartiteMatchingProblem =
+    StaticMatroidProblem<MatchingProblem::PartitionMatroidSet,
+                         MatchingProblem::PartitionMatroidSet>;
+using Static3DMatchingProblem =
+    StaticMatroidProblem<MatchingProblem::PartitionMatroidSet,
+                         MatchingProblem::PartitionMatroidSet,
+                         MatchingProblem::PartitionMatroidSet>;
+using StaticHamiltonianPathProblem = StaticMatroidProblem<
+    HamiltonianPathProblem::SingleIncomingEdgeMatroidSet,
+    HamiltonianPathProblem::SingleIncomingEdgeMatroidSet,
+    HamiltonianPathProblem::PathForestGraphicMatroidSet>;
+
+StaticBipartiteMatchingProblem makeStaticBipartiteMatchingProblem(
+    int vertexPerPartitionCount,
+    const std::shared_ptr<const HyperedgeList> &edges);
+
+Static3DMatchingProblem
+makeStatic3DMatchingProblem(int vertexPerPartitionCount,
+                            const std::shared_ptr<const HyperedgeList> &edges);
+
+// The matroids share edges, (from, to) columns
+StaticHamiltonianPathProblem makeStaticHamiltonianPathProblem(
+    int vertexCount, const std::shared_ptr<const HyperedgeList> &edges);
+
+StaticHamiltonianPathProblem
+makeStaticHamiltonianPathProblem(int vertexCount,
+                                 const std::vector<std::pair<int, int>> &edges);
+
 #endif // MATROID_IMPLEMENTATIONS_H
\ No newline at end of file
@@ -1,11 +1,18 @@
 #ifndef MATROID_INTERSECTION_H
 #define MATROID_INTERSECTION_H
 
+#include "conflict_index.h"
+#include "deadline.h"
+#include "element_order.h"
 #include "matroid_implementations.h"
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <set>
 #include <vector>
 
+// approximationRatio is the guaranteed fraction of the optimum: of its size,
+// or of its weight for the weighted algorithms
 class ApproximationSolution {
 public:
   ApproximationSolution(double approximationRatio, std::vector<int> solution);
@@ -17,42 +24,404 @@ private:
   std::vector<int> solution_;
 };
 
-// Baseline greedy algorithm: 1/k approximation
-class BaselineAlgorithm {
+// The greedy and local search algorithms are templated on the problem type:
+// either the virtual MatroidProblem or one of the StaticMatroidProblem
+// aliases, for which the independence checks inline. They are explicitly
+// instantiated for these types in matroid_intersection.cpp.
+//
+// Every algorithm can be given a Deadline (never, by default), e.g. a batch
+// runner's cancellation flag: local search then stops early with the
+// solution it has, as on its own time limit, and the others throw
+// DeadlineExceeded.
+
+// Baseline greedy algorithm: 1/k approximation whatever the element order
+// (element_order.h); scanning the elements by decreasing weight
+// (orderByDecreasingWeight) makes it the weighted greedy, a 1/k
+// approximation of the maximum weight
+template <typename Problem> class BasicBaselineAlgorithm {
 public:
-  BaselineAlgorithm(const std::shared_ptr<MatroidProblem> &matroidProblem);
+  BasicBaselineAlgorithm(const std::shared_ptr<Problem> &matroidProblem);
 
   // Run the baseline algorithm
   ApproximationSolution run();
 
+  // Order in which the ground set is scanned; identity by default
+  void setElementOrder(std::vector<int> elementOrder) {
+    elementOrder_ = std::move(elementOrder);
+  }
+
+  void setDeadline(Deadline deadline) { deadline_ = deadline; }
+
 private:
-  std::shared_ptr<MatroidProblem> matroidProblem_;
+  std::shared_ptr<Problem> matroidProblem_;
+  Deadline deadline_;
+  std::vector<int> elementOrder_;
 };
 
+using BaselineAlgorithm = BasicBaselineAlgorithm<MatroidProblem>;
+
 class Kuhn2dMatchingAlgorithm {
 public:
   Kuhn2dMatchingAlgorithm(
       const std::shared_ptr<MatchingProblem> &matchingProblem);
 
+  // Run repeated Kuhn augmentations (recursive DFS), O(VE)
+  ApproximationSolution run();
+
+  void setDeadline(Deadline deadline) { deadline_ = deadline; }
+
+private:
+  std::shared_ptr<MatchingProblem> matchingProblem_;
+  Deadline deadline_;
+};
+
+// Hopcroft-Karp on a CSR adjacency: BFS distance layers from the free left
+// vertices, then vertex-disjoint shortest augmenting paths found by an
+// iterative DFS; O(E sqrt(V)) and safe for large sparse graphs
+class HopcroftKarpMatchingAlgorithm {
+public:
+  HopcroftKarpMatchingAlgorithm(
+      const std::shared_ptr<MatchingProblem> &matchingProblem);
+
   // Run the Hopcroft-Karp algorithm
   ApproximationSolution run();
 
+  // Number of BFS phases of the last run
+  int getPhaseCount() const { return phaseCount_; }
+
+  void setDeadline(Deadline deadline) { deadline_ = deadline; }
+
 private:
   std::shared_ptr<MatchingProblem> matchingProblem_;
+  Deadline deadline_;
+  int phaseCount_ = 0;
+};
+
+// Exact maximum intersection of two matroids through the MatroidSet
+// interface: Cunningham-style shortest augmenting paths in the exchange graph,
+// several vertex-disjoint paths per BFS phase
+class ExchangeGraphIntersectionAlgorithm {
+public:
+  ExchangeGraphIntersectionAlgorithm(
+      const std::shared_ptr<MatroidProblem> &matroidProblem);
+
+  // Run the algorithm, starting from the current (independent) set
+  ApproximationSolution run();
+
+  int getPhaseCount() const { return phaseCount_; }
+
+  int getAugmentationCount() const { return augmentationCount_; }
+
+  void setDeadline(Deadline deadline) { deadline_ = deadline; }
+
+private:
+  std::shared_ptr<MatroidProblem> matroidProblem_;
+  Deadline deadline_;
+  int phaseCount_ = 0;
+  int augmentationCount_ = 0;
+};
+
+// One improving exchange of a local search run: when it was found (seconds
+// since the run started), in which step s, how many elements it removed and
+// inserted, the solution size after it, and the insertion candidates
+// queried up to it
+struct LocalSearchTraceEntry {
+  double seconds;
+  int step;
+  int removals;
+  int insertions;
+  int solutionSize;
+  std::int64_t candidateChecks;
 };
 
 // Local search algorithm: 2/(k+epsilon) approximation
-class LocalSearchAlgorithm {
+template <typename Problem> class BasicLocalSearchAlgorithm {
 public:
-  LocalSearchAlgorithm(const std::shared_ptr<MatroidProblem> &matroidProblem,
-                       int timeLimitSeconds);
+  // Each run stops timeLimit after it starts, at the latest
+  BasicLocalSearchAlgorithm(const std::shared_ptr<Problem> &matroidProblem,
+                            std::chrono::milliseconds timeLimit);
 
   // Run the local search algorithm
   std::vector<ApproximationSolution> run();
 
+  // Order in which the ground set is scanned; identity by default
+  void setElementOrder(std::vector<int> elementOrder) {
+    elementOrder_ = std::move(elementOrder);
+  }
+
+  // Whether to report progress to std::cerr; on by default
+  void setVerbose(bool verbose) { verbose_ = verbose; }
+
+  // Threads exploring the removal combinations of each exchange attempt, on
+  // a work-stealing pool with one problem clone per thread; 1 by default,
+  // which keeps the search sequential and deterministic
+  void setThreadCount(int threadCount) { threadCount_ = threadCount; }
+
+  // Conflict index of a partition-matroid problem, matching its (empty)
+  // initial state; insertions after removing a set are then drawn only from
+  // the elements touching the removed ones. Same results, fewer oracle calls
+  void setConflictIndex(std::shared_ptr<const PartitionConflictIndex> index) {
+    conflictIndex_ = std::move(index);
+  }
+
+  // Last step s (remove s, add s + 1) to run, so that a run doesn't depend
+  // on the time limit; unlimited (-1) by default
+  void setMaxStep(int maxStep) { maxStep_ = maxStep; }
+
+  // Stops the run if it comes before the time limit
+  void setDeadline(Deadline deadline) { deadline_ = deadline; }
+
+  // Independent set to start from instead of the empty one, e.g. the
+  // baseline solution; the problem is still expected to be empty. A
+  // non-empty one skips step 0 (greedy additions, which the first attempt
+  // of step 1 still makes) and puts the whole time budget into s >= 1
+  void setInitialSolution(std::vector<int> initialSolution) {
+    initialSolution_ = std::move(initialSolution);
+  }
+
+  // Counters of the last run, summed over the worker threads: removal sets
+  // whose insertions were tried, improvements found, and insertion
+  // candidates queried (independence oracle calls of the problem)
+  std::int64_t getExchangeAttemptCount() const { return exchangeAttempts_; }
+  std::int64_t getImprovementCount() const { return improvements_; }
+  std::int64_t getCandidateCheckCount() const { return candidateChecks_; }
+
+  // Every improvement of the last run in the steps s >= 1, in order; the
+  // greedy insertions of step 0 are left out, so an entry costs a clock read
+  // per exchange of the actual search
+  const std::vector<LocalSearchTraceEntry> &getTrace() const {
+    return trace_;
+  }
+
+  // Seconds since the start of the last run at which each returned solution
+  // (one per step) was completed
+  const std::vector<double> &getStepSeconds() const { return stepSeconds_; }
+
 private:
-  std::shared_ptr<MatroidProblem> matroidProblem_;
-  int timeLimitSeconds_;
+  std::shared_ptr<Problem> matroidProblem_;
+  std::chrono::milliseconds timeLimit_;
+  Deadline deadline_;
+  std::vector<int> elementOrder_;
+  bool verbose_ = true;
+  int threadCount_ = 1;
+  int maxStep_ = -1;
+  std::vector<int> initialSolution_;
+  std::shared_ptr<const PartitionConflictIndex> conflictIndex_;
+  std::int64_t exchangeAttempts_ = 0;
+  std::int64_t improvements_ = 0;
+  std::int64_t candidateChecks_ = 0;
+  std::vector<LocalSearchTraceEntry> trace_;
+  std::vector<double> stepSeconds_;
 };
 
+using LocalSearchAlgorithm = BasicLocalSearchAlgorithm<MatroidProblem>;
+
+// Multi-start local search: independent local searches on clones of the
+// problem, one per thread, each scanning the ground set in its own random
+// order (thread 0 keeps the natural order) under the same time limit
+template <typename Problem> class BasicParallelLocalSearchAlgorithm {
+public:
+  struct ThreadStatistics {
+    unsigned int seed;
+    int solutionSize;
+    int completedSteps; // solutions returned by the thread's local search
+    double approximationRatio;
+    double elapsedSeconds;
+    std::vector<LocalSearchTraceEntry> trace; // of the thread's local search
+  };
+
+  BasicParallelLocalSearchAlgorithm(
+      const std::shared_ptr<Problem> &matroidProblem,
+      std::chrono::milliseconds timeLimit, int threadCount, unsigned int seed);
+
+  // Run all local searches and return the largest solution found
+  ApproximationSolution run();
+
+  // Per-thread outcome of the last run, indexed by thread
+  const std::vector<ThreadStatistics> &getThreadStatistics() const {
+    return threadStatistics_;
+  }
+
+  // See BasicLocalSearchAlgorithm::setConflictIndex
+  void setConflictIndex(std::shared_ptr<const PartitionConflictIndex> index) {
+    conflictIndex_ = std::move(index);
+  }
+
+  // See BasicLocalSearchAlgorithm::setInitialSolution; every thread starts
+  // from it
+  void setInitialSolution(std::vector<int> initialSolution) {
+    initialSolution_ = std::move(initialSolution);
+  }
+
+  // See BasicLocalSearchAlgorithm::setDeadline; it stops every thread
+  void setDeadline(Deadline deadline) { deadline_ = deadline; }
+
+private:
+  std::shared_ptr<Problem> matroidProblem_;
+  std::chrono::milliseconds timeLimit_;
+  Deadline deadline_;
+  int threadCount_;
+  unsigned int seed_;
+  std::vector<int> initialSolution_;
+  std::shared_ptr<const PartitionConflictIndex> conflictIndex_;
+  std::vector<ThreadStatistics> threadStatistics_;
+};
+
+using ParallelLocalSearchAlgorithm =
+    BasicParallelLocalSearchAlgorithm<MatroidProblem>;
+
+// Sampling local search, for the removal sizes at which the exhaustive
+// enumeration of BasicLocalSearchAlgorithm can't finish a step. Each sample
+// removes 1 to maxRemovals solution elements and repairs the solution
+// greedily, in random order, from the elements that may enter. With a
+// conflict index the removed elements form a cluster: each further one is a
+// random conflict of a random neighbour of those removed, so that they may
+// make room for an exchange, and the repair scans only their neighbours.
+// Without one they are drawn uniformly and the repair scans the ground set.
+//
+// A sample that grows the solution is kept. One that keeps its size is kept
+// with the annealing acceptance, a probability that cools geometrically per
+// sample (0 by default: only improvements); the others are rolled back.
+// After restartInterval samples without a new best solution, the search
+// restarts from a greedy solution in a fresh random order. Without an index,
+// or with one covering every matroid, the solution stays maximal, so the
+// best one found is a 1/k approximation.
+template <typename Problem> class BasicSamplingLocalSearchAlgorithm {
+public:
+  // The run stops timeLimit after it starts, at the latest; seed draws the
+  // samples
+  BasicSamplingLocalSearchAlgorithm(
+      const std::shared_ptr<Problem> &matroidProblem,
+      std::chrono::milliseconds timeLimit, unsigned int seed);
+
+  // Run the search from the initial solution, or the greedy one in index
+  // order; the problem is expected to be empty, and keeps the last solution
+  ApproximationSolution run();
+
+  // Largest number of elements a sample removes; 3 by default
+  void setMaxRemovals(int maxRemovals) { maxRemovals_ = maxRemovals; }
+
+  // See BasicLocalSearchAlgorithm::setConflictIndex
+  void setConflictIndex(std::shared_ptr<const PartitionConflictIndex> index) {
+    conflictIndex_ = std::move(index);
+  }
+
+  // Probability of keeping a sample of equal size, multiplied by cooling
+  // after every sample and reset by a restart
+  void setAnnealing(double initialAcceptance, double cooling) {
+    initialAcceptance_ = initialAcceptance;
+    cooling_ = cooling;
+  }
+
+  // Samples without a new best solution before a restart, 0 for never;
+  // 100000 by default
+  void setRestartInterval(std::int64_t samples) { restartInterval_ = samples; }
+
+  // Number of samples to draw, so that a run doesn't depend on the time
+  // limit; unlimited (-1) by default
+  void setMaxSamples(std::int64_t maxSamples) { maxSamples_ = maxSamples; }
+
+  // See BasicLocalSearchAlgorithm::setInitialSolution
+  void setInitialSolution(std::vector<int> initialSolution) {
+    initialSolution_ = std::move(initialSolution);
+  }
+
+  // Stops the run if it comes before the time limit
+  void setDeadline(Deadline deadline) { deadline_ = deadline; }
+
+  // Counters of the last run: samples drawn, samples kept because they grew
+  // the solution or kept its size, and restarts
+  std::int64_t getSampleCount() const { return samples_; }
+  std::int64_t getImprovementCount() const { return improvements_; }
+  std::int64_t getPlateauMoveCount() const { return plateauMoves_; }
+  std::int64_t getRestartCount() const { return restarts_; }
+  double getElapsedSeconds() const { return elapsedSeconds_; }
+  double getSamplesPerSecond() const {
+    return elapsedSeconds_ > 0 ? samples_ / elapsedSeconds_ : 0;
+  }
+
+private:
+  std::shared_ptr<Problem> matroidProblem_;
+  std::chrono::milliseconds timeLimit_;
+  unsigned int seed_;
+  Deadline deadline_;
+  int maxRemovals_ = 3;
+  double initialAcceptance_ = 0;
+  double cooling_ = 1;
+  std::int64_t restartInterval_ = 100000;
+  std::int64_t maxSamples_ = -1;
+  std::vector<int> initialSolution_;
+  std::shared_ptr<const PartitionConflictIndex> conflictIndex_;
+  std::int64_t samples_ = 0;
+  std::int64_t improvements_ = 0;
+  std::int64_t plateauMoves_ = 0;
+  std::int64_t restarts_ = 0;
+  double elapsedSeconds_ = 0;
+};
+
+using SamplingLocalSearchAlgorithm =
+    BasicSamplingLocalSearchAlgorithm<MatroidProblem>;
+
+// Weighted local search over swaps: an element x enters the solution, the
+// solution elements it conflicts with in a PartitionConflictIndex (at most
+// one per partition) leave, and the vertices they free are refilled with
+// the heaviest elements that fit there, so that a swap can be an augmenting
+// path of length 3. A swap is made if it gains weight, the largest gain
+// first. The gains are kept in a lazily updated max-heap: a swap changes the
+// conflicts only of the elements sharing a vertex with the moved ones, which
+// are re-evaluated and pushed, so the ground set is scanned once rather than
+// once per swap. The refills of the elements two hops further may change
+// too; they, and the swaps the problem rejected, are kept for the next
+// round, which re-seeds the heap from them alone. The rounds end with one
+// that makes no swap. From the empty set the first swaps are the weighted
+// greedy ones.
+//
+// If the index covers every matroid of the problem, as for the matchings,
+// the problem accepts every swap the index allows, and a local optimum is a
+// 1/k approximation of the maximum weight. Otherwise (e.g. a Hamiltonian
+// path, whose index covers the degree matroids but not the graphic one) the
+// problem may reject the element or a refill, and no ratio is guaranteed
+// (0).
+template <typename Problem> class BasicWeightedLocalSearchAlgorithm {
+public:
+  // conflictIndex matches the (empty) initial state of the problem; the run
+  // stops timeLimit after it starts, at the latest
+  BasicWeightedLocalSearchAlgorithm(
+      const std::shared_ptr<Problem> &matroidProblem,
+      std::shared_ptr<const PartitionConflictIndex> conflictIndex,
+      std::chrono::milliseconds timeLimit);
+
+  // Run the local search; the solution stays in the problem
+  ApproximationSolution run();
+
+  // See BasicLocalSearchAlgorithm::setInitialSolution, e.g. the weighted
+  // greedy solution
+  void setInitialSolution(std::vector<int> initialSolution) {
+    initialSolution_ = std::move(initialSolution);
+  }
+
+  // Stops the run if it comes before the time limit
+  void setDeadline(Deadline deadline) { deadline_ = deadline; }
+
+  // Counters of the last run: swaps made, gains evaluated (each a conflict
+  // lookup), and rounds: the first over the ground set, the others over the
+  // elements left pending by the one before
+  std::int64_t getImprovementCount() const { return improvements_; }
+  std::int64_t getGainEvaluationCount() const { return gainEvaluations_; }
+  int getRoundCount() const { return roundCount_; }
+
+private:
+  std::shared_ptr<Problem> matroidProblem_;
+  std::shared_ptr<const PartitionConflictIndex> conflictIndex_;
+  std::chrono::milliseconds timeLimit_;
+  Deadline deadline_;
+  std::vector<int> initialSolution_;
+  std::int64_t improvements_ = 0;
+  std::int64_t gainEvaluations_ = 0;
+  int roundCount_ = 0;
+};
+
+using WeightedLocalSearchAlgorithm =
+    BasicWeightedLocalSearchAlgorithm<MatroidProblem>;
+
 #endif // MATROID_INTERSECTION_H
@@ -1,6 +1,12 @@
 #ifndef MATROID_H
 #define MATROID_H
 
+#include "element_weights.h"
+#include "matroid_check_order.h"
+#include "oracle_counters.h"
+#include "undo_log.h"
+#include <cstdint>
+#include <memory>
 #include <set>
 #include <unordered_set>
 #include <vector>
@@ -12,34 +18,152 @@ public:
   // Constructor that initializes the ground set size
   explicit MatroidProblem(int groundSetSize, int matroidQuatity)
       : groundSetSize_(groundSetSize), matroidQuantity_(matroidQuatity),
-        setMembership_(groundSetSize, false) {}
+        setMembership_(groundSetSize, false), counters_(matroidQuatity) {}
+
+  // Deep copy, including the current set
+  MatroidProblem(const MatroidProblem &other);
+
+  virtual ~MatroidProblem() = default;
+
+  // Independent copy of the problem and its current set, e.g. one per thread
+  virtual std::unique_ptr<MatroidProblem> clone() const {
+    return std::make_unique<MatroidProblem>(*this);
+  }
 
   // Attempt to add an element to all underlying matroid sets
   // Returns true if the element was successfully added to all sets, false
-  // otherwise If any addition fails, all previous additions are rolled back
+  // otherwise; all sets are queried before any of them is modified
   bool tryAddElement(int element);
 
+  // Add an element already known to keep every set independent (canAdd)
+  void addElement(int element);
+
+  // True if the element is not in the set and adding it keeps every matroid
+  // independent; doesn't modify the state
+  bool canAdd(int element) const;
+
+  // True if swapping removed (in the set) for added keeps every matroid
+  // independent; doesn't modify the state
+  bool canExchange(int removed, int added) const;
+
+  // Batched canAdd: of the elements elements[i] whose bit i is set in mask
+  // (count <= 32), those that canAdd accepts; doesn't modify the state. The
+  // bits >= count must be zero; they are cleared before any matroid sees
+  // them
+  std::uint32_t canAddBatch(const int *elements, int count,
+                            std::uint32_t mask) const;
+
   // Remove an element from all underlying matroid sets
   void removeElement(int element);
 
-  // Reset the set membership to all false
+  // Reset the set membership to all false, in O(|set|); closes every
+  // checkpoint
   void reset();
 
+  // Transactional backtracking: checkpoint() opens a checkpoint at the
+  // current set, after which the additions and removals are logged;
+  // rollback(checkpoint) takes them back, newest first, and commit keeps
+  // them. Either closes the checkpoint and every one opened after it.
+  // Undone additions are removed, and undone removals are put back without
+  // asking the matroids (restoreElement); both count as undo operations.
+  std::size_t checkpoint() { return undoLog_.checkpoint(); }
+  void rollback(std::size_t checkpoint);
+  void commit(std::size_t checkpoint) { undoLog_.commit(checkpoint); }
+
+  // rollback calling onUndo(element, wasAdded) after undoing each change,
+  // e.g. to keep a mirror of the set in sync
+  template <typename OnUndo>
+  void rollback(std::size_t checkpoint, const OnUndo &onUndo) {
+    undoLog_.rollback(checkpoint, [this, &onUndo](int element, bool wasAdded) {
+      undo(element, wasAdded);
+      onUndo(element, wasAdded);
+    });
+  }
+
+  // Whether the matroids are queried in an order adapted to their observed
+  // rejection rates (MatroidCheckOrder), on by default; the answers are the
+  // same either way. Additions always go in construction order.
+  void setAdaptiveCheckOrder(bool adaptive);
+
+  // Matroid indices in the order they are currently queried
+  const std::vector<std::size_t> &getCheckOrder() const;
+
+  // Oracle calls since construction or the last reset of the counters,
+  // zeros unless built with MATROID_ORACLE_COUNTERS; a clone copies them
+  const OracleCounters &getOracleCounters() const { return counters_; }
+  void resetOracleCounters() { counters_.reset(); }
+  void mergeOracleCounters(const OracleCounters &other) {
+    counters_.merge(other);
+  }
+
+  // Per-element weights, e.g. from GraphGenerator::generateWeights, shared
+  // with the clones; null (the default) weighs every element 1
+  void setWeights(ElementWeights weights) {
+    if (weights) {
+      checkElementWeights(*weights, groundSetSize_);
+    }
+    weights_ = std::move(weights);
+  }
+  const ElementWeights &getWeights() const { return weights_; }
+  bool isWeighted() const { return weights_ != nullptr; }
+  double getWeight(int element) const {
+    return weights_ ? (*weights_)[element] : 1.0;
+  }
+
   // A subset of the ground set; the inner class enhances efficiency
   class MatroidSet {
   public:
     virtual ~MatroidSet() = default;
 
+    // Independent copy of the set and its state
+    virtual std::unique_ptr<MatroidSet> clone() const = 0;
+
     // Add element only if the set remains independent, otherwise return false
     virtual bool tryAddElement(int element) = 0;
 
+    // Whether tryAddElement would succeed, without modifying the set
+    virtual bool canAdd(int element) const = 0;
+
+    // Whether the set stays independent after removing removed (which is in
+    // the set) and adding added, without modifying the set
+    virtual bool canExchange(int removed, int added) const = 0;
+
+    // canAdd over the elements selected by mask, as in
+    // MatroidProblem::canAddBatch; one canAdd call per selected element
+    // unless overridden
+    virtual std::uint32_t canAddBatch(const int *elements, int count,
+                                      std::uint32_t mask) const;
+
+    // Relative cost of a canAdd or canExchange query, 1 for a constant-time
+    // lookup; weighs the rejection rate when ordering the checks
+    virtual double getQueryCost() const { return 1.0; }
+
+    // Bytes of the set's own state (memory_usage.h), without the shared
+    // edge storage; 0 unless overridden
+    virtual std::size_t getMemoryBytes() const { return 0; }
+
     // Remove element
     virtual void removeElement(int element) = 0;
+
+    // Add back an element removed since the set was last in its current
+    // state, which is thus known to keep it independent; skips the check
+    // unless not overridden
+    virtual void restoreElement(int element);
   };
   int getGroundSetSize() const { return groundSetSize_; }
 
   int getMatroidQuantity() const { return matroidQuantity_; }
 
+  // True if the element is in the current set
+  bool contains(int element) const { return setMembership_[element]; }
+
+  // Read access to a single matroid, e.g. for exchange graph queries
+  const MatroidSet &getMatroid(int index) const { return *matroids_[index]; }
+
+  // Bytes of the problem's state: the matroid sets, the membership, the
+  // member list and the undo log (memory_usage.h)
+  std::size_t getMemoryBytes() const;
+
 protected:
   int groundSetSize_;   // the size of the shared ground set
   int matroidQuantity_; // the quantity of the matroids to intersect
@@ -47,6 +171,23 @@ protected:
       matroids_; // the matroids to intersect
   std::vector<bool>
       setMembership_; // true if the element is in the intersection
+  mutable OracleCounters counters_; // updated by the const queries too
+  mutable MatroidCheckOrder checkOrder_;
+  bool adaptiveCheckOrder_ = true;
+  MemberList members_; // for reset()
+  UndoLog undoLog_;
+  ElementWeights weights_;
+
+private:
+  // Takes back the logged addition or removal of element
+  void undo(int element, bool wasAdded);
+
+  // removeElement without the membership check and the bookkeeping
+  void eraseElement(int element);
+
+  // matroids_ is filled by the subclass constructors: the order is built on
+  // the first query, and again if matroids are added later
+  MatroidCheckOrder &checkOrder() const;
 };
 
 #endif // MATROID_H
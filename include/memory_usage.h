@@ -0,0 +1,30 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <cstddef>
+#include <vector>
+
+// Memory accounting. The data structures report the bytes of their buffers
+// by capacity, which never shrinks, so a report is the high-water mark of
+// each structure; shared storage (an edge list, a conflict index's incidence
+// lists) is reported by its owner only. The process figures are the
+// resident set size.
+
+template <typename T> std::size_t getVectorBytes(const std::vector<T> &v) {
+  return v.capacity() * sizeof(T);
+}
+
+inline std::size_t getVectorBytes(const std::vector<bool> &v) {
+  return (v.capacity() + 7) / 8;
+}
+
+// Resident set size of the process, now and at its peak, in bytes; 0 where
+// the platform doesn't tell
+struct ProcessMemory {
+  std::size_t currentBytes = 0;
+  std::size_t peakBytes = 0;
+};
+
+ProcessMemory getProcessMemory();
+
+#endif // MEMORY_USAGE_H
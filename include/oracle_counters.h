@@ -0,0 +1,97 @@
+#ifndef ORACLE_COUNTERS_H
+#define ORACLE_COUNTERS_H
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Oracle-call counters of a problem, kept only in a build with
+// -DMATROID_ORACLE_COUNTERS=ON; otherwise every count compiles away and the
+// counters stay zero.
+#ifdef MATROID_ORACLE_COUNTERS
+inline constexpr bool kOracleCountersEnabled = true;
+#else
+inline constexpr bool kOracleCountersEnabled = false;
+#endif
+
+// Queries answered by one matroid of a problem. The matroids of a query are
+// asked in order and the first rejection ends it, so rejections tell on
+// which matroid the queries fail, and a later matroid only sees the queries
+// all the earlier ones accepted.
+struct MatroidCounters {
+  std::int64_t canAddCalls = 0; // batched candidates included
+  std::int64_t canAddRejections = 0;
+  std::int64_t canExchangeCalls = 0;
+  std::int64_t canExchangeRejections = 0;
+};
+
+struct OracleCounters {
+  std::vector<MatroidCounters> matroids; // in the problem's order
+  std::int64_t additions = 0;
+  std::int64_t removals = 0;
+  // tryAddElement calls that failed; they only read the matroids, so there
+  // is never anything to roll back
+  std::int64_t rejectedAdditions = 0;
+  // the part of the additions and removals that undoes an earlier one, e.g.
+  // a failed local search branch taking back its insertion
+  std::int64_t undoAdditions = 0;
+  std::int64_t undoRemovals = 0;
+
+  explicit OracleCounters(int matroidCount = 0) : matroids(matroidCount) {}
+
+  // Records the canAdd answer of the given matroid and passes it through
+  bool countCanAdd(std::size_t matroid, bool accepted) {
+    if constexpr (kOracleCountersEnabled) {
+      matroids[matroid].canAddCalls++;
+      matroids[matroid].canAddRejections += !accepted;
+    }
+    return accepted;
+  }
+
+  // Records a canAddBatch call of the given matroid over count candidates,
+  // which kept the accepted ones of those queried; only the bits below count
+  // are counted. Returns accepted
+  std::uint32_t countCanAddBatch(std::size_t matroid, int count,
+                                 std::uint32_t queried,
+                                 std::uint32_t accepted) {
+    if constexpr (kOracleCountersEnabled) {
+      queried &= count >= 32 ? ~std::uint32_t{0}
+                             : (std::uint32_t{1} << count) - 1;
+      matroids[matroid].canAddCalls += std::bitset<32>(queried).count();
+      matroids[matroid].canAddRejections +=
+          std::bitset<32>(queried & ~accepted).count();
+    }
+    return accepted;
+  }
+
+  bool countCanExchange(std::size_t matroid, bool accepted) {
+    if constexpr (kOracleCountersEnabled) {
+      matroids[matroid].canExchangeCalls++;
+      matroids[matroid].canExchangeRejections += !accepted;
+    }
+    return accepted;
+  }
+
+  // Adds the counts of other, e.g. of a worker's clone of the problem
+  void merge(const OracleCounters &other) {
+    for (std::size_t i = 0; i < matroids.size() && i < other.matroids.size();
+         i++) {
+      matroids[i].canAddCalls += other.matroids[i].canAddCalls;
+      matroids[i].canAddRejections += other.matroids[i].canAddRejections;
+      matroids[i].canExchangeCalls += other.matroids[i].canExchangeCalls;
+      matroids[i].canExchangeRejections +=
+          other.matroids[i].canExchangeRejections;
+    }
+    additions += other.additions;
+    removals += other.removals;
+    rejectedAdditions += other.rejectedAdditions;
+    undoAdditions += other.undoAdditions;
+    undoRemovals += other.undoRemovals;
+  }
+
+  // Zeroes every count
+  void reset() { *this = OracleCounters(static_cast<int>(matroids.size())); }
+};
+
+#endif // ORACLE_COUNTERS_H
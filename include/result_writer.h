@@ -0,0 +1,69 @@
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+#include "hyperedge_list.h"
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Streaming writer of the output of one problem: the graph is written edge by
+// edge and each solution as soon as it is added, so neither the graph nor the
+// whole output is ever held as a JSON document.
+//
+// Json writes one document, {"graph": ..., "problem_name": ..., "solutions":
+// [...]}, with "instance": <path> instead of "graph" for a referenced graph
+// and neither for an omitted one. Ndjson writes one record per line: first
+// {"record": "problem", ...} with the same graph fields, then one
+// {"record": "solution", ...} per solution. A memory report given to end
+// goes last, under "memory" or as a {"record": "memory", ...} line. An
+// output that fails is completed by fail instead, with "error": <message>
+// after the solutions or as a {"record": "error", ...} line, so that what
+// was written still parses.
+class ResultWriter {
+public:
+  enum class Format { Json, Ndjson };
+
+  // What the output says about the graph
+  enum class GraphMode {
+    Inline,    // the edges themselves
+    Omit,      // nothing
+    Reference, // the path of the instance file holding it
+  };
+
+  // Writes the graph part of the output, e.g. writeEdges bound to the edges
+  using GraphWriter = std::function<void(std::ostream &)>;
+
+  ResultWriter(std::ostream &out, Format format, GraphMode graphMode,
+               std::string instancePath = "");
+
+  // Starts the output; writeGraph is only called for an inline graph
+  void begin(const std::string &problemName, const GraphWriter &writeGraph);
+
+  // One solution object, written and flushed right away
+  void addSolution(const nlohmann::json &solution);
+
+  // Completes the output, with the memory report unless it is null
+  void end(const nlohmann::json &memory = nullptr);
+
+  // Completes a begun output with the error instead; nothing before begin
+  // or after end
+  void fail(const std::string &message);
+
+private:
+  std::ostream &out_;
+  Format format_;
+  GraphMode graphMode_;
+  std::string instancePath_;
+  bool firstSolution_ = true;
+  bool open_ = false; // between begin and end or fail
+};
+
+// The edges as a JSON array of vertex arrays, without building a document
+void writeEdges(std::ostream &out, const HyperedgeList &edges);
+void writeEdges(std::ostream &out,
+                const std::vector<std::pair<int, int>> &edges);
+
+#endif // RESULT_WRITER_H
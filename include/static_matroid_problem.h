@@ -0,0 +1,287 @@
+#ifndef STATIC_MATROID_PROBLEM_H
+#define STATIC_MATROID_PROBLEM_H
+
+#include "element_weights.h"
+#include "matroid_check_order.h"
+#include "oracle_counters.h"
+#include "undo_log.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Compile-time composed counterpart of MatroidProblem: the matroid sets are
+// stored by value in a tuple and called through their concrete (final) types,
+// so the independence check inlines without virtual dispatch or heap
+// indirection. Sets are added in template argument order and queried in an
+// adaptive order (MatroidCheckOrder).
+template <typename... Sets> class StaticMatroidProblem {
+public:
+  explicit StaticMatroidProblem(int groundSetSize, Sets... sets)
+      : groundSetSize_(groundSetSize), matroids_(std::move(sets)...),
+        setMembership_(groundSetSize, false), counters_(sizeof...(Sets)),
+        checkOrder_(std::apply(
+            [](const auto &...matroid) {
+              return std::vector<double>{matroid.getQueryCost()...};
+            },
+            matroids_)) {}
+
+  // Independent copy of the problem and its current set, e.g. one per thread
+  std::unique_ptr<StaticMatroidProblem> clone() const {
+    return std::make_unique<StaticMatroidProblem>(*this);
+  }
+
+  // Attempt to add an element to all underlying matroid sets
+  // Returns true if the element was successfully added to all sets, false
+  // otherwise; all sets are queried before any of them is modified
+  bool tryAddElement(int element) {
+    if (!canAdd(element)) {
+      if constexpr (kOracleCountersEnabled) {
+        counters_.rejectedAdditions++;
+      }
+      return false;
+    }
+    addElement(element);
+    return true;
+  }
+
+  // Add an element already known to keep every set independent (canAdd)
+  void addElement(int element) {
+    bool added = std::apply(
+        [element](auto &...matroid) {
+          return (matroid.tryAddElement(element) && ...);
+        },
+        matroids_);
+    if (!added) {
+      throw std::logic_error("Element rejected after passing canAdd");
+    }
+    setMembership_[element] = true;
+    members_.add(element, setMembership_);
+    undoLog_.recordAddition(element);
+    if constexpr (kOracleCountersEnabled) {
+      counters_.additions++;
+    }
+  }
+
+  // True if the element is not in the set and adding it keeps every matroid
+  // independent; doesn't modify the state
+  bool canAdd(int element) const {
+    return !setMembership_[element] && canAddAll(element);
+  }
+
+  // True if swapping removed (in the set) for added keeps every matroid
+  // independent; doesn't modify the state
+  bool canExchange(int removed, int added) const {
+    return setMembership_[removed] && !setMembership_[added] &&
+           canExchangeAll(removed, added);
+  }
+
+  // Batched canAdd: of the elements elements[i] whose bit i is set in mask
+  // (count <= 32), those that canAdd accepts; doesn't modify the state. The
+  // bits >= count must be zero; they are cleared before any matroid sees
+  // them
+  std::uint32_t canAddBatch(const int *elements, int count,
+                            std::uint32_t mask) const {
+    mask &= count >= 32 ? ~std::uint32_t{0} : (std::uint32_t{1} << count) - 1;
+    for (int i = 0; i < count; i++) {
+      if (setMembership_[elements[i]]) {
+        mask &= ~(std::uint32_t{1} << i);
+      }
+    }
+    return canAddBatchAll(elements, count, mask);
+  }
+
+  // Remove an element from all underlying matroid sets
+  void removeElement(int element) {
+    if (!setMembership_[element]) {
+      throw std::invalid_argument("Element not in the set");
+    }
+    eraseElement(element);
+    members_.remove();
+    undoLog_.recordRemoval(element);
+  }
+
+  // Reset the set membership to all false, in O(|set|); closes every
+  // checkpoint
+  void reset() {
+    undoLog_.clear();
+    // an element added more than once since the last compaction is listed
+    // more than once
+    for (int element : members_.takeAll()) {
+      if (setMembership_[element]) {
+        eraseElement(element);
+      }
+    }
+  }
+
+  // Transactional backtracking, as in MatroidProblem: rollback takes back
+  // the additions and removals since the checkpoint, newest first, calling
+  // onUndo(element, wasAdded) after each; undone removals are restored
+  // without asking the matroids
+  std::size_t checkpoint() { return undoLog_.checkpoint(); }
+
+  void rollback(std::size_t checkpoint) {
+    rollback(checkpoint, [](int, bool) {});
+  }
+
+  template <typename OnUndo>
+  void rollback(std::size_t checkpoint, const OnUndo &onUndo) {
+    undoLog_.rollback(checkpoint, [this, &onUndo](int element, bool wasAdded) {
+      undo(element, wasAdded);
+      onUndo(element, wasAdded);
+    });
+  }
+
+  void commit(std::size_t checkpoint) { undoLog_.commit(checkpoint); }
+
+  int getGroundSetSize() const { return groundSetSize_; }
+
+  int getMatroidQuantity() const { return sizeof...(Sets); }
+
+  // Whether the matroids are queried in an order adapted to their observed
+  // rejection rates (MatroidCheckOrder), on by default; the answers are the
+  // same either way. Additions always go in template argument order.
+  void setAdaptiveCheckOrder(bool adaptive) {
+    checkOrder_.setAdaptive(adaptive);
+  }
+
+  // Matroid indices in the order they are currently queried
+  const std::vector<std::size_t> &getCheckOrder() const {
+    return checkOrder_.getOrder();
+  }
+
+  // Oracle calls since construction or the last reset of the counters,
+  // zeros unless built with MATROID_ORACLE_COUNTERS; a clone copies them
+  const OracleCounters &getOracleCounters() const { return counters_; }
+  void resetOracleCounters() { counters_.reset(); }
+  void mergeOracleCounters(const OracleCounters &other) {
+    counters_.merge(other);
+  }
+
+  // Bytes of the problem's state, as in MatroidProblem
+  std::size_t getMemoryBytes() const {
+    std::size_t bytes = getVectorBytes(setMembership_) +
+                        members_.getMemoryBytes() + undoLog_.getMemoryBytes();
+    std::apply(
+        [&bytes](const auto &...matroid) {
+          ((bytes += matroid.getMemoryBytes()), ...);
+        },
+        matroids_);
+    return bytes;
+  }
+
+  // Per-element weights, as in MatroidProblem; null weighs every element 1
+  void setWeights(ElementWeights weights) {
+    if (weights) {
+      checkElementWeights(*weights, groundSetSize_);
+    }
+    weights_ = std::move(weights);
+  }
+  const ElementWeights &getWeights() const { return weights_; }
+  bool isWeighted() const { return weights_ != nullptr; }
+  double getWeight(int element) const {
+    return weights_ ? (*weights_)[element] : 1.0;
+  }
+
+private:
+  using Indices = std::index_sequence_for<Sets...>;
+
+  // removeElement without the membership check and the bookkeeping
+  void eraseElement(int element) {
+    std::apply(
+        [element](auto &...matroid) { (matroid.removeElement(element), ...); },
+        matroids_);
+    setMembership_[element] = false;
+    if constexpr (kOracleCountersEnabled) {
+      counters_.removals++;
+    }
+  }
+
+  // Takes back the logged addition or removal of element
+  void undo(int element, bool wasAdded) {
+    if (wasAdded) {
+      eraseElement(element);
+      members_.remove();
+      if constexpr (kOracleCountersEnabled) {
+        counters_.undoRemovals++;
+      }
+      return;
+    }
+    std::apply(
+        [element](auto &...matroid) { (matroid.restoreElement(element), ...); },
+        matroids_);
+    setMembership_[element] = true;
+    members_.add(element, setMembership_);
+    if constexpr (kOracleCountersEnabled) {
+      counters_.additions++;
+      counters_.undoAdditions++;
+    }
+  }
+
+  // The answer of matroid i to query, a callable taking the matroid set
+  template <typename Query, std::size_t... I>
+  auto ask(std::size_t i, const Query &query,
+           std::index_sequence<I...>) const {
+    decltype(query(std::get<0>(matroids_))) answer{};
+    ((i == I && (answer = query(std::get<I>(matroids_)), true)) || ...);
+    return answer;
+  }
+
+  // The queries over the matroids in check order
+  bool canAddAll(int element) const {
+    return checkOrder_.query([this, element](std::size_t i) {
+      return counters_.countCanAdd(
+          i, ask(
+                 i,
+                 [element](const auto &matroid) {
+                   return matroid.canAdd(element);
+                 },
+                 Indices{}));
+    });
+  }
+
+  bool canExchangeAll(int removed, int added) const {
+    return checkOrder_.query([this, removed, added](std::size_t i) {
+      return counters_.countCanExchange(
+          i, ask(
+                 i,
+                 [removed, added](const auto &matroid) {
+                   return matroid.canExchange(removed, added);
+                 },
+                 Indices{}));
+    });
+  }
+
+  std::uint32_t canAddBatchAll(const int *elements, int count,
+                               std::uint32_t mask) const {
+    if (mask == 0) {
+      return 0;
+    }
+    return checkOrder_.queryBatch(
+        mask, [this, elements, count](std::size_t i, std::uint32_t queried) {
+          return counters_.countCanAddBatch(
+              i, count, queried,
+              ask(
+                  i,
+                  [elements, count, queried](const auto &matroid) {
+                    return matroid.canAddBatch(elements, count, queried);
+                  },
+                  Indices{}));
+        });
+  }
+
+  int groundSetSize_;
+  std::tuple<Sets...> matroids_; // the matroids to intersect
+  std::vector<bool>
+      setMembership_; // true if the element is in the intersection
+  mutable OracleCounters counters_; // updated by the const queries too
+  mutable MatroidCheckOrder checkOrder_;
+  MemberList members_; // for reset()
+  UndoLog undoLog_;
+  ElementWeights weights_;
+};
+
+#endif // STATIC_MATROID_PROBLEM_H
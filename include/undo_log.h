@@ -0,0 +1,122 @@
+#ifndef UNDO_LOG_H
+#define UNDO_LOG_H
+
+#include "memory_usage.h"
+#include <cstddef>
+#include <vector>
+
+// Log of the additions and removals of a problem's current set since the
+// oldest open checkpoint, for transactional backtracking. Checkpoints nest:
+// rolling back or committing one closes it and every later one, and nothing
+// is logged while none is open.
+class UndoLog {
+public:
+  // Opens a checkpoint at the current state
+  std::size_t checkpoint() {
+    marks_.push_back(entries_.size());
+    return marks_.size() - 1;
+  }
+
+  void recordAddition(int element) {
+    if (!marks_.empty()) {
+      entries_.push_back(element);
+    }
+  }
+
+  void recordRemoval(int element) {
+    if (!marks_.empty()) {
+      entries_.push_back(~element);
+    }
+  }
+
+  // Pops the entries since the checkpoint, newest first, calling
+  // undo(element, wasAdded) for each, and closes the checkpoint
+  template <typename Undo>
+  void rollback(std::size_t checkpoint, const Undo &undo) {
+    std::size_t begin = marks_[checkpoint];
+    while (entries_.size() > begin) {
+      int entry = entries_.back();
+      entries_.pop_back();
+      if (entry >= 0) {
+        undo(entry, true);
+      } else {
+        undo(~entry, false);
+      }
+    }
+    close(checkpoint);
+  }
+
+  // Keeps the changes since the checkpoint and closes it
+  void commit(std::size_t checkpoint) { close(checkpoint); }
+
+  // Closes every checkpoint
+  void clear() {
+    marks_.clear();
+    entries_.clear();
+  }
+
+  std::size_t getMemoryBytes() const {
+    return getVectorBytes(entries_) + getVectorBytes(marks_);
+  }
+
+private:
+  void close(std::size_t checkpoint) {
+    marks_.resize(checkpoint);
+    if (marks_.empty()) {
+      entries_.clear();
+    }
+  }
+
+  std::vector<int> entries_; // an element added, or ~element removed
+  std::vector<std::size_t> marks_; // log size at each open checkpoint
+};
+
+// The elements of a problem's current set, so that reset() costs O(|set|)
+// instead of a scan of the ground set: each added element is appended, and
+// the list is compacted to the current members once it holds more than
+// twice as many entries, so it never outgrows 2 |set| + kSlack
+class MemberList {
+public:
+  static constexpr std::size_t kSlack = 64;
+
+  void add(int element, std::vector<bool> &membership) {
+    elements_.push_back(element);
+    ++size_;
+    if (elements_.size() > 2 * size_ + kSlack) {
+      compact(membership);
+    }
+  }
+
+  void remove() { --size_; }
+
+  // The entries, among them every member, and empties the list
+  std::vector<int> takeAll() {
+    std::vector<int> all;
+    all.swap(elements_);
+    size_ = 0;
+    return all;
+  }
+
+  std::size_t getMemoryBytes() const { return getVectorBytes(elements_); }
+
+private:
+  // Keeps each member once; a kept element is marked by clearing its bit
+  void compact(std::vector<bool> &membership) {
+    std::size_t kept = 0;
+    for (int element : elements_) {
+      if (membership[element]) {
+        membership[element] = false;
+        elements_[kept++] = element;
+      }
+    }
+    elements_.resize(kept);
+    for (int element : elements_) {
+      membership[element] = true;
+    }
+  }
+
+  std::vector<int> elements_;
+  std::size_t size_ = 0;
+};
+
+#endif // UNDO_LOG_H
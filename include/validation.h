@@ -1,18 +1,69 @@
 #ifndef VALIDATION_H
 #define VALIDATION_H
 
+#include "hyperedge_list.h"
+#include <cstddef>
+#include <memory>
 #include <utility>
 #include <vector>
 
-void validate_bipartite_matching(int n,
-                                 const std::vector<std::pair<int, int>> &edges,
+// Validators that check the input once, on construction, and then every
+// solution in O(|solution|): membership and the used vertices are marked in
+// scratch bitsets that are cleared again after each check, so there is
+// neither a sort nor an allocation per solution. Inputs of 2^20 edges and
+// more are checked in parallel chunks, which stop early once one fails.
+// Errors throw std::invalid_argument, "Input failed validation: ..." or
+// "Solution error: ...". Not thread-safe: one validator per thread.
+
+// A matching in a rank-partite hypergraph of n vertices per partition
+class MatchingValidator {
+public:
+  MatchingValidator(int n, std::shared_ptr<const HyperedgeList> edges,
+                    int rank);
+
+  void validate(const std::vector<int> &solution) const;
+
+  // Bytes of the scratch state
+  std::size_t getMemoryBytes() const;
+
+private:
+  int n_;
+  std::shared_ptr<const HyperedgeList> edges_;
+  mutable std::vector<bool> inSolution_; // [E]
+  mutable std::vector<bool> used_;       // [rank * n]
+};
+
+// A set of directed edges, the (from, to) columns of edges, forming
+// vertex-disjoint simple paths
+class HamiltonianPathValidator {
+public:
+  HamiltonianPathValidator(int n, std::shared_ptr<const HyperedgeList> edges);
+
+  void validate(const std::vector<int> &solution) const;
+
+  // Bytes of the scratch state
+  std::size_t getMemoryBytes() const;
+
+private:
+  int n_;
+  std::shared_ptr<const HyperedgeList> edges_;
+  const int *from_;                      // [E] tails
+  const int *to_;                        // [E] heads
+  mutable std::vector<bool> inSolution_; // [E]
+  mutable std::vector<int> incoming_;    // [V] solution edge into, or -1
+  mutable std::vector<int> outgoing_;    // [V] solution edge out of, or -1
+};
+
+// One-shot checks of the input and one solution
+
+void validate_bipartite_matching(int n, const HyperedgeList &edges,
                                  const std::vector<int> &solution);
 
-void validate_3d_matching(int n, const std::vector<std::vector<int>> &edges,
+void validate_3d_matching(int n, const HyperedgeList &edges,
                           const std::vector<int> &solution);
 
 void validate_hamiltonian_path(int n,
                                const std::vector<std::pair<int, int>> &edges,
                                const std::vector<int> &solution);
 
-#endif // VALIDATION_H
\ No newline at end of file
+#endif // VALIDATION_H
@@ -0,0 +1,107 @@
+#include "component_decomposition.h"
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+
+// Union-find over the elements, by size with path halving
+class DisjointSets {
+public:
+  explicit DisjointSets(int size) : parent_(size), size_(size, 1) {
+    std::iota(parent_.begin(), parent_.end(), 0);
+  }
+
+  int find(int x) {
+    while (parent_[x] != x) {
+      parent_[x] = parent_[parent_[x]];
+      x = parent_[x];
+    }
+    return x;
+  }
+
+  void unite(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) {
+      return;
+    }
+    if (size_[a] < size_[b]) {
+      std::swap(a, b);
+    }
+    parent_[b] = a;
+    size_[a] += size_[b];
+  }
+
+private:
+  std::vector<int> parent_;
+  std::vector<int> size_;
+};
+
+} // namespace
+
+std::vector<GraphComponent>
+decomposeIntoComponents(int vertexCount, const HyperedgeList &edges,
+                        ComponentVertices vertices) {
+  int edgesCount = edges.size();
+  int rank = edges.getRank();
+  bool shared = vertices == ComponentVertices::Shared;
+  int vertexSlots = shared ? vertexCount : rank * vertexCount;
+  // the slot of the vertex of edge i in partition p
+  auto slotOf = [&](int edge, int p) {
+    int vertex = edges.getVertex(edge, p);
+    if (vertex < 0 || vertex >= vertexCount) {
+      throw std::invalid_argument("Vertex index out of bounds");
+    }
+    return shared ? vertex : p * vertexCount + vertex;
+  };
+
+  // every element joins the first one seen at each of its vertices
+  DisjointSets sets(edgesCount);
+  std::vector<int> firstEdge(vertexSlots, -1);
+  for (int p = 0; p < rank; p++) {
+    for (int edge_i = 0; edge_i < edgesCount; edge_i++) {
+      int &first = firstEdge[slotOf(edge_i, p)];
+      if (first == -1) {
+        first = edge_i;
+      } else {
+        sets.unite(first, edge_i);
+      }
+    }
+  }
+
+  // components numbered by their smallest element
+  std::vector<int> componentOf(edgesCount, -1); // indexed by the root
+  std::vector<GraphComponent> components;
+  for (int edge_i = 0; edge_i < edgesCount; edge_i++) {
+    int &component = componentOf[sets.find(edge_i)];
+    if (component == -1) {
+      component = static_cast<int>(components.size());
+      components.push_back({0, nullptr, {}});
+    }
+    components[component].elements.push_back(edge_i);
+  }
+
+  // renumber the vertices of each component in the order its edges meet
+  // them; a vertex lies in one component, so one table serves all
+  std::vector<int> localVertex(vertexSlots, -1);
+  for (auto &component : components) {
+    std::vector<int> partitionSize(shared ? 1 : rank, 0);
+    std::vector<std::vector<int>> columns(
+        rank, std::vector<int>(component.elements.size()));
+    for (int p = 0; p < rank; p++) {
+      int &nextVertex = partitionSize[shared ? 0 : p];
+      for (std::size_t i = 0; i < component.elements.size(); i++) {
+        int &local = localVertex[slotOf(component.elements[i], p)];
+        if (local == -1) {
+          local = nextVertex++;
+        }
+        columns[p][i] = local;
+      }
+    }
+    component.vertexCount =
+        *std::max_element(partitionSize.begin(), partitionSize.end());
+    component.edges =
+        std::make_shared<const HyperedgeList>(std::move(columns));
+  }
+  return components;
+}
@@ -0,0 +1,100 @@
+#include "conflict_index.h"
+#include "memory_usage.h"
+#include <algorithm>
+#include <stdexcept>
+
+PartitionConflictIndex::PartitionConflictIndex(
+    int vertexPerPartitionCount, std::shared_ptr<const HyperedgeList> edges) {
+  int graphRank = edges->getRank();
+  int edgesCount = edges->size();
+  auto incidence = std::make_shared<Incidence>();
+  incidence->offset.assign(graphRank,
+                           std::vector<int>(vertexPerPartitionCount + 1, 0));
+  incidence->incident.assign(graphRank, std::vector<int>(edgesCount));
+  for (int p = 0; p < graphRank; ++p) {
+    const int *vertexOf = edges->getColumn(p);
+    auto &offset = incidence->offset[p];
+    for (int edge_i = 0; edge_i < edgesCount; ++edge_i) {
+      int vertex = vertexOf[edge_i];
+      if (vertex < 0 || vertex >= vertexPerPartitionCount) {
+        throw std::invalid_argument("Vertex index out of bounds");
+      }
+      ++offset[vertex + 1];
+    }
+    for (int v = 0; v < vertexPerPartitionCount; ++v) {
+      offset[v + 1] += offset[v];
+    }
+    std::vector<int> fill(offset.begin(), offset.end() - 1);
+    for (int edge_i = 0; edge_i < edgesCount; ++edge_i) {
+      incidence->incident[p][fill[vertexOf[edge_i]]++] = edge_i;
+    }
+    incidence->vertexOf.push_back(vertexOf);
+  }
+  incidence->edges = std::move(edges);
+  incidence_ = std::move(incidence);
+  owner_.assign(graphRank, std::vector<int>(vertexPerPartitionCount, -1));
+}
+
+void PartitionConflictIndex::addElement(int element) {
+  for (size_t p = 0; p < owner_.size(); ++p) {
+    owner_[p][incidence_->vertexOf[p][element]] = element;
+  }
+}
+
+void PartitionConflictIndex::removeElement(int element) {
+  for (size_t p = 0; p < owner_.size(); ++p) {
+    owner_[p][incidence_->vertexOf[p][element]] = -1;
+  }
+}
+
+void PartitionConflictIndex::appendConflicts(
+    int element, std::vector<int> &conflicts) const {
+  auto first = conflicts.size();
+  for (size_t p = 0; p < owner_.size(); ++p) {
+    int owner = owner_[p][incidence_->vertexOf[p][element]];
+    // one owner may cover several of element's vertices
+    if (owner != -1 && std::find(conflicts.begin() + first, conflicts.end(),
+                                 owner) == conflicts.end()) {
+      conflicts.push_back(owner);
+    }
+  }
+}
+
+bool PartitionConflictIndex::isFree(int element) const {
+  for (size_t p = 0; p < owner_.size(); ++p) {
+    if (owner_[p][incidence_->vertexOf[p][element]] != -1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PartitionConflictIndex::appendNeighbours(
+    int element, std::vector<int> &neighbours) const {
+  for (size_t p = 0; p < owner_.size(); ++p) {
+    int vertex = incidence_->vertexOf[p][element];
+    const auto &offset = incidence_->offset[p];
+    const auto &incident = incidence_->incident[p];
+    neighbours.insert(neighbours.end(), incident.begin() + offset[vertex],
+                      incident.begin() + offset[vertex + 1]);
+  }
+}
+
+std::size_t PartitionConflictIndex::getMemoryBytes() const {
+  std::size_t bytes = getVectorBytes(owner_);
+  for (const auto &owners : owner_) {
+    bytes += getVectorBytes(owners);
+  }
+  return bytes;
+}
+
+std::size_t PartitionConflictIndex::getSharedMemoryBytes() const {
+  std::size_t bytes = getVectorBytes(incidence_->vertexOf) +
+                      getVectorBytes(incidence_->offset) +
+                      getVectorBytes(incidence_->incident);
+  for (std::size_t p = 0; p < incidence_->offset.size(); p++) {
+    bytes += getVectorBytes(incidence_->offset[p]) +
+             getVectorBytes(incidence_->incident[p]);
+  }
+  return bytes;
+}
@@ -0,0 +1,239 @@
+#include "element_order.h"
+#include "conflict_index.h"
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+// Elements keyed by a non-negative count that only decreases, in one doubly
+// linked list per key; the minimum key is found by a cursor that an update
+// moves down by at most one and a pop moves up past the empty buckets
+class BucketQueue {
+public:
+  explicit BucketQueue(std::vector<int> keys)
+      : key_(std::move(keys)), next_(key_.size()), previous_(key_.size()),
+        queued_(key_.size(), true), size_(static_cast<int>(key_.size())) {
+    int maxKey = 0;
+    for (int key : key_) {
+      maxKey = std::max(maxKey, key);
+    }
+    head_.assign(maxKey + 1, -1);
+    // pushed to the front from the last, so each bucket is in index order
+    for (int element = size_ - 1; element >= 0; element--) {
+      pushFront(element);
+    }
+    minKey_ = 0;
+  }
+
+  bool empty() const { return size_ == 0; }
+
+  bool contains(int element) const { return queued_[element]; }
+
+  // Removes and returns an element of the smallest key; not empty
+  int popMin() {
+    while (head_[minKey_] == -1) {
+      ++minKey_;
+    }
+    int element = head_[minKey_];
+    erase(element);
+    return element;
+  }
+
+  void erase(int element) {
+    unlink(element);
+    queued_[element] = false;
+    --size_;
+  }
+
+  // Decreases the key of a queued element by one
+  void decrement(int element) {
+    unlink(element);
+    --key_[element];
+    pushFront(element);
+    minKey_ = std::min(minKey_, key_[element]);
+  }
+
+private:
+  void pushFront(int element) {
+    int &head = head_[key_[element]];
+    previous_[element] = -1;
+    next_[element] = head;
+    if (head != -1) {
+      previous_[head] = element;
+    }
+    head = element;
+  }
+
+  void unlink(int element) {
+    if (previous_[element] != -1) {
+      next_[previous_[element]] = next_[element];
+    } else {
+      head_[key_[element]] = next_[element];
+    }
+    if (next_[element] != -1) {
+      previous_[next_[element]] = previous_[element];
+    }
+  }
+
+  std::vector<int> key_;
+  std::vector<int> head_; // [maxKey + 1] first element of each key, or -1
+  std::vector<int> next_;
+  std::vector<int> previous_;
+  std::vector<bool> queued_;
+  int size_;
+  int minKey_ = 0;
+};
+
+} // namespace
+
+ElementOrdering parseElementOrdering(const std::string &name) {
+  if (name == "index") {
+    return ElementOrdering::Index;
+  }
+  if (name == "mindegree") {
+    return ElementOrdering::MinDegree;
+  }
+  if (name == "random") {
+    return ElementOrdering::Random;
+  }
+  if (name == "fewestconflicts") {
+    return ElementOrdering::FewestConflicts;
+  }
+  throw std::invalid_argument("Unknown element order: " + name);
+}
+
+const char *getElementOrderingName(ElementOrdering ordering) {
+  switch (ordering) {
+  case ElementOrdering::Index:
+    return "index";
+  case ElementOrdering::MinDegree:
+    return "mindegree";
+  case ElementOrdering::Random:
+    return "random";
+  case ElementOrdering::FewestConflicts:
+    return "fewestconflicts";
+  }
+  throw std::invalid_argument("Unknown element order");
+}
+
+std::vector<int>
+computeElementOrder(ElementOrdering ordering, int vertexCount,
+                    const std::shared_ptr<const HyperedgeList> &edges,
+                    unsigned int seed) {
+  switch (ordering) {
+  case ElementOrdering::Index: {
+    std::vector<int> order(edges->size());
+    std::iota(order.begin(), order.end(), 0);
+    return order;
+  }
+  case ElementOrdering::MinDegree:
+    return orderByMinDegree(vertexCount, *edges);
+  case ElementOrdering::Random:
+    return orderRandomly(edges->size(), seed);
+  case ElementOrdering::FewestConflicts:
+    return orderByFewestConflicts(vertexCount, edges);
+  }
+  throw std::invalid_argument("Unknown element order");
+}
+
+std::vector<int> orderByMinDegree(int vertexCount, const HyperedgeList &edges) {
+  int edgesCount = edges.size();
+  std::vector<int> key(edgesCount, 0);
+  for (int p = 0; p < edges.getRank(); p++) {
+    const int *vertexOf = edges.getColumn(p);
+    std::vector<int> degree(vertexCount, 0);
+    for (int edge_i = 0; edge_i < edgesCount; edge_i++) {
+      if (vertexOf[edge_i] < 0 || vertexOf[edge_i] >= vertexCount) {
+        throw std::invalid_argument("Vertex index out of bounds");
+      }
+      ++degree[vertexOf[edge_i]];
+    }
+    for (int edge_i = 0; edge_i < edgesCount; edge_i++) {
+      key[edge_i] += degree[vertexOf[edge_i]] - 1;
+    }
+  }
+  // counting sort; a key is below rank * E
+  int maxKey = 0;
+  for (int k : key) {
+    maxKey = std::max(maxKey, k);
+  }
+  std::vector<int> start(maxKey + 2, 0);
+  for (int k : key) {
+    ++start[k + 1];
+  }
+  std::partial_sum(start.begin(), start.end(), start.begin());
+  std::vector<int> order(edgesCount);
+  for (int edge_i = 0; edge_i < edgesCount; edge_i++) {
+    order[start[key[edge_i]]++] = edge_i;
+  }
+  return order;
+}
+
+std::vector<int> orderRandomly(int elementCount, unsigned int seed) {
+  std::vector<int> order(elementCount);
+  std::iota(order.begin(), order.end(), 0);
+  std::mt19937 rng(seed);
+  std::shuffle(order.begin(), order.end(), rng);
+  return order;
+}
+
+std::vector<int>
+orderByFewestConflicts(int vertexCount,
+                       const std::shared_ptr<const HyperedgeList> &edges) {
+  // only the incidence lists of the index are used: the neighbours of an
+  // element are listed once per shared vertex, itself once per partition
+  PartitionConflictIndex incidence(vertexCount, edges);
+  int edgesCount = edges->size();
+  int rank = edges->getRank();
+  std::vector<int> neighbours;
+  std::vector<int> keys(edgesCount);
+  for (int edge_i = 0; edge_i < edgesCount; edge_i++) {
+    neighbours.clear();
+    incidence.appendNeighbours(edge_i, neighbours);
+    keys[edge_i] = static_cast<int>(neighbours.size()) - rank;
+  }
+  BucketQueue queue(std::move(keys));
+
+  std::vector<int> order;
+  order.reserve(edgesCount);
+  std::vector<int> blocked;
+  std::vector<int> newlyBlocked;
+  while (!queue.empty()) {
+    int element = queue.popMin();
+    order.push_back(element);
+    // every available neighbour of element is blocked, so only theirs
+    // lose a conflict
+    neighbours.clear();
+    incidence.appendNeighbours(element, neighbours);
+    newlyBlocked.clear();
+    for (int neighbour : neighbours) {
+      if (queue.contains(neighbour)) {
+        queue.erase(neighbour);
+        newlyBlocked.push_back(neighbour);
+      }
+    }
+    for (int blockedElement : newlyBlocked) {
+      neighbours.clear();
+      incidence.appendNeighbours(blockedElement, neighbours);
+      for (int neighbour : neighbours) {
+        if (queue.contains(neighbour)) {
+          queue.decrement(neighbour);
+        }
+      }
+    }
+    blocked.insert(blocked.end(), newlyBlocked.begin(), newlyBlocked.end());
+  }
+  order.insert(order.end(), blocked.begin(), blocked.end());
+  return order;
+}
+
+std::vector<int> orderByDecreasingWeight(const std::vector<double> &weights) {
+  std::vector<int> order(weights.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&weights](int a, int b) {
+    return weights[a] > weights[b];
+  });
+  return order;
+}
@@ -1,95 +1,322 @@
 #include "graph_generator.h"
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <exception>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
 
-GraphGenerator::GraphGenerator(unsigned int seed)
-    : rng_(seed), dist_(0.0, 1.0) {}
+namespace {
 
-std::vector<std::pair<int, int>>
-GraphGenerator::generateErdosRenyiBipartite(int n, double p) {
-  std::vector<std::pair<int, int>> edges;
+// SplitMix64 finalizer: a bijection with good avalanche, so consecutive
+// counters give independent-looking outputs
+std::uint64_t mix64(std::uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
 
-  for (int i = 0; i < n; ++i) {
-    for (int j = 0; j < n; ++j) {
-      if (dist_(rng_) < p) {
-        edges.emplace_back(i, j);
+// Counter-based uniform stream: the k-th draw is a function of (key, k) only,
+// so a stream can start anywhere without running the ones before it
+class CounterStream {
+public:
+  explicit CounterStream(std::uint64_t key) : state_(key) {}
+
+  // uniform in [0, 1)
+  double operator()() {
+    state_ += 0x9e3779b97f4a7c15ULL;
+    return static_cast<double>(mix64(state_) >> 11) * 0x1.0p-53;
+  }
+
+private:
+  std::uint64_t state_;
+};
+
+// candidates per counter-based stream; fixed, so the graph doesn't depend on
+// how the blocks are spread over the threads
+constexpr std::int64_t kSampleBlock = std::int64_t{1} << 16;
+
+// Calls emit(index) for every index of [begin, end) kept with probability p,
+// in increasing order, drawing from uniform (values in [0, 1))
+template <typename Uniform, typename Emit>
+void sampleRange(std::int64_t begin, std::int64_t end, double p,
+                 GraphGenerator::SamplingMode mode, Uniform &uniform,
+                 Emit &&emit) {
+  if (mode == GraphGenerator::SamplingMode::PerCandidate) {
+    for (std::int64_t index = begin; index < end; ++index) {
+      if (uniform() < p) {
+        emit(index);
       }
     }
+    return;
   }
+  if (p <= 0.0) {
+    return;
+  }
+  if (p >= 1.0) {
+    for (std::int64_t index = begin; index < end; ++index) {
+      emit(index);
+    }
+    return;
+  }
+  // the number of candidates skipped before the next kept one is geometric:
+  // floor(log(U) / log(1 - p)) for U uniform in (0, 1]
+  double logMiss = std::log1p(-p);
+  std::int64_t index = begin;
+  while (true) {
+    double skip = std::floor(std::log(1.0 - uniform()) / logMiss);
+    // compared as a double first: the skip may not fit in an integer
+    if (skip >= static_cast<double>(end - index)) {
+      return;
+    }
+    index += static_cast<std::int64_t>(skip);
+    emit(index);
+    ++index;
+  }
+}
 
-  return edges;
+// Concatenation of the columns of consecutive parts of an edge list
+template <std::size_t Rank>
+HyperedgeList
+concatenateColumns(std::vector<std::array<std::vector<int>, Rank>> &parts) {
+  std::vector<std::vector<int>> columns(Rank);
+  if (parts.size() == 1) {
+    for (std::size_t c = 0; c < Rank; ++c) {
+      columns[c] = std::move(parts[0][c]);
+    }
+    return HyperedgeList(std::move(columns));
+  }
+  for (std::size_t c = 0; c < Rank; ++c) {
+    std::size_t size = 0;
+    for (const auto &part : parts) {
+      size += part[c].size();
+    }
+    columns[c].reserve(size);
+    for (auto &part : parts) {
+      columns[c].insert(columns[c].end(), part[c].begin(), part[c].end());
+      std::vector<int>().swap(part[c]);
+    }
+  }
+  return HyperedgeList(std::move(columns));
 }
 
 std::vector<std::pair<int, int>>
-GraphGenerator::generateCompleteBipartite(int n) {
+concatenatePairs(std::vector<std::vector<std::pair<int, int>>> &parts) {
+  if (parts.size() == 1) {
+    return std::move(parts[0]);
+  }
+  std::size_t size = 0;
+  for (const auto &part : parts) {
+    size += part.size();
+  }
   std::vector<std::pair<int, int>> edges;
+  edges.reserve(size);
+  for (auto &part : parts) {
+    edges.insert(edges.end(), part.begin(), part.end());
+    std::vector<std::pair<int, int>>().swap(part);
+  }
+  return edges;
+}
 
-  for (int i = 0; i < n; ++i) {
-    for (int j = 0; j < n; ++j) {
-      edges.emplace_back(i, j);
+} // namespace
+
+GraphGenerator::GraphGenerator(unsigned int seed, SamplingMode mode,
+                               int threadCount)
+    : mode_(mode), threadCount_(threadCount), seed_(seed), rng_(seed),
+      dist_(0.0, 1.0) {
+  if (threadCount < 0) {
+    throw std::invalid_argument("threadCount must be non-negative");
+  }
+}
+
+template <typename Part, typename Emit>
+std::vector<Part> GraphGenerator::sampleParts(std::int64_t total, double p,
+                                              Emit emit) {
+  if (threadCount_ == 0) {
+    std::vector<Part> parts(1);
+    auto uniform = [this]() { return dist_(rng_); };
+    sampleRange(0, total, p, mode_, uniform,
+                [&](std::int64_t index) { emit(parts[0], index); });
+    return parts;
+  }
+
+  // every call gets its own key, like the draws of a sequential stream
+  std::uint64_t key = mix64(mix64(seed_) + ++streamCount_);
+  std::int64_t blockCount = (total + kSampleBlock - 1) / kSampleBlock;
+  int partCount = static_cast<int>(
+      std::max<std::int64_t>(1, std::min<std::int64_t>(threadCount_,
+                                                       blockCount)));
+  std::vector<Part> parts(partCount);
+  std::vector<std::exception_ptr> errors(partCount);
+  // part t holds the consecutive blocks [blockCount * t / partCount,
+  // blockCount * (t + 1) / partCount)
+  auto sampleBlocks = [&](int t) {
+    try {
+      std::int64_t firstBlock = blockCount * t / partCount;
+      std::int64_t lastBlock = blockCount * (t + 1) / partCount;
+      for (std::int64_t block = firstBlock; block < lastBlock; ++block) {
+        CounterStream uniform(mix64(key + static_cast<std::uint64_t>(block)));
+        sampleRange(block * kSampleBlock,
+                    std::min(total, (block + 1) * kSampleBlock), p, mode_,
+                    uniform,
+                    [&](std::int64_t index) { emit(parts[t], index); });
+      }
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int t = 1; t < partCount; t++) {
+    threads.emplace_back(sampleBlocks, t);
+  }
+  sampleBlocks(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (const auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
     }
   }
+  return parts;
+}
 
-  return edges;
+HyperedgeList GraphGenerator::generateErdosRenyiBipartite(int n, double p) {
+  // candidate (i, j) is index i * n + j
+  auto parts = sampleParts<std::array<std::vector<int>, 2>>(
+      std::int64_t{n} * n, p, [n](auto &columns, std::int64_t index) {
+        columns[0].push_back(static_cast<int>(index / n));
+        columns[1].push_back(static_cast<int>(index % n));
+      });
+  return concatenateColumns(parts);
 }
 
-std::vector<std::pair<int, int>> GraphGenerator::generateRandomGraph(int n,
-                                                                     double p) {
-  std::vector<std::pair<int, int>> edges;
+HyperedgeList GraphGenerator::generateCompleteBipartite(int n) {
+  std::vector<std::vector<int>> columns(2);
+  for (auto &column : columns) {
+    column.reserve(static_cast<size_t>(n) * n);
+  }
 
   for (int i = 0; i < n; ++i) {
-    for (int j = i + 1; j < n; ++j) {
-      if (dist_(rng_) < p) {
-        edges.emplace_back(i, j);
-      }
+    for (int j = 0; j < n; ++j) {
+      columns[0].push_back(i);
+      columns[1].push_back(j);
     }
   }
 
-  return edges;
+  return HyperedgeList(std::move(columns));
+}
+
+std::vector<std::pair<int, int>> GraphGenerator::generateRandomGraph(int n,
+                                                                     double p) {
+  // candidates (i, j) with i < j, row by row: row i starts at index
+  // rowStart(i) = i * (2n - 1 - i) / 2
+  auto rowStart = [n](std::int64_t i) { return i * (2 * n - 1 - i) / 2; };
+  auto parts = sampleParts<std::vector<std::pair<int, int>>>(
+      std::int64_t{n} * (n - 1) / 2, p,
+      [n, rowStart](auto &edges, std::int64_t index) {
+        // invert rowStart in floating point, then fix the rounding
+        double b = 2.0 * n - 1;
+        auto i = static_cast<std::int64_t>(
+            (b - std::sqrt(b * b - 8.0 * static_cast<double>(index))) / 2);
+        i = std::max<std::int64_t>(0, std::min<std::int64_t>(i, n - 2));
+        while (i > 0 && rowStart(i) > index) {
+          --i;
+        }
+        while (rowStart(i + 1) <= index) {
+          ++i;
+        }
+        edges.emplace_back(static_cast<int>(i),
+                           static_cast<int>(i + 1 + index - rowStart(i)));
+      });
+  return concatenatePairs(parts);
 }
 
 std::vector<std::pair<int, int>>
 GraphGenerator::generateRandomDirectedGraph(int n, double p,
                                             int minHamiltonianPathLength) {
-  if (minHamiltonianPathLength > n || minHamiltonianPathLength < 0) {
+  // a path of that many edges visits one more vertex
+  if (minHamiltonianPathLength < 0 ||
+      (minHamiltonianPathLength > 0 && minHamiltonianPathLength >= n)) {
     throw std::invalid_argument(
-        "minHamiltonianPathLength must be between 0 and n");
+        "minHamiltonianPathLength must be between 0 and n - 1");
   }
   std::vector<int> random_permutation(n);
   std::iota(random_permutation.begin(), random_permutation.end(), 0);
   std::shuffle(random_permutation.begin(), random_permutation.end(), rng_);
-  std::vector<std::pair<int, int>> edges;
+  // the path leaves every vertex at most once
+  std::vector<int> pathNext(n, -1);
   for (int i = 0; i < minHamiltonianPathLength; ++i) {
-    edges.emplace_back(random_permutation[i], random_permutation[i + 1]);
+    pathNext[random_permutation[i]] = random_permutation[i + 1];
   }
 
-  for (int i = 0; i < n; ++i) {
-    for (int j = 0; j < n; ++j) {
-      if (i != j && dist_(rng_) < p) {
-        edges.emplace_back(i, j);
+  // candidate (i, j), i != j, is index i * (n - 1) + j, less one when j > i
+  std::vector<std::vector<std::pair<int, int>>> parts;
+  if (n > 1) {
+    parts = sampleParts<std::vector<std::pair<int, int>>>(
+        std::int64_t{n} * (n - 1), p, [n](auto &edges, std::int64_t index) {
+          int i = static_cast<int>(index / (n - 1));
+          int j = static_cast<int>(index % (n - 1));
+          edges.emplace_back(i, j < i ? j : j + 1);
+        });
+  }
+
+  // The random edges come sorted; merge the path edges in at their sorted
+  // position, dropping the random copy of any path edge
+  std::size_t randomCount = 0;
+  for (const auto &part : parts) {
+    randomCount += part.size();
+  }
+  std::vector<std::pair<int, int>> edges;
+  edges.reserve(randomCount + minHamiltonianPathLength);
+  int source = 0; // the path edges leaving vertices < source are placed
+  auto placePathEdgesBefore = [&](int from, int to) {
+    while (source < n &&
+           (source < from || (source == from && pathNext[source] < to))) {
+      if (pathNext[source] != -1) {
+        edges.emplace_back(source, pathNext[source]);
       }
+      ++source;
     }
+  };
+  for (auto &part : parts) {
+    for (const auto &[from, to] : part) {
+      placePathEdgesBefore(from, to);
+      if (source == from && pathNext[source] == to) {
+        ++source;
+      }
+      edges.emplace_back(from, to);
+    }
+    std::vector<std::pair<int, int>>().swap(part);
   }
-
-  std::sort(edges.begin(), edges.end());
-  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+  placePathEdgesBefore(n, 0);
 
   return edges;
 }
 
-std::vector<std::vector<int>> GraphGenerator::generate3DGraph(int n, double p) {
-  std::vector<std::vector<int>> hyperedges;
-
+HyperedgeList GraphGenerator::generate3DGraph(int n, double p) {
   // Generate tripartite hypergraph: each hyperedge connects one vertex from
-  // each partition
-  for (int i = 0; i < n; ++i) {
-    for (int j = 0; j < n; ++j) {
-      for (int k = 0; k < n; ++k) {
-        if (dist_(rng_) < p) {
-          hyperedges.push_back({i, j, k});
-        }
-      }
-    }
-  }
+  // each partition; candidate (i, j, k) is index (i * n + j) * n + k
+  auto parts = sampleParts<std::array<std::vector<int>, 3>>(
+      std::int64_t{n} * n * n, p, [n](auto &columns, std::int64_t index) {
+        columns[0].push_back(static_cast<int>(index / n / n));
+        columns[1].push_back(static_cast<int>(index / n % n));
+        columns[2].push_back(static_cast<int>(index % n));
+      });
+  return concatenateColumns(parts);
+}
 
-  return hyperedges;
+std::vector<double> GraphGenerator::generateWeights(int elementCount,
+                                                    int maxWeight) {
+  if (maxWeight < 1) {
+    throw std::invalid_argument("maxWeight must be at least 1");
+  }
+  // keyed apart from the sampling streams, which add a count to mix64(seed)
+  CounterStream uniform(mix64(~mix64(seed_)));
+  std::vector<double> weights(elementCount);
+  for (double &weight : weights) {
+    weight = 1 + std::floor(uniform() * maxWeight);
+  }
+  return weights;
 }
@@ -0,0 +1,61 @@
+#include "hyperedge_list.h"
+#include "memory_usage.h"
+#include <stdexcept>
+
+HyperedgeList::HyperedgeList(std::vector<std::vector<int>> columns)
+    : size_(columns.empty() ? 0 : static_cast<int>(columns[0].size())),
+      ownedColumns_(std::move(columns)) {
+  for (const auto &column : ownedColumns_) {
+    if (static_cast<int>(column.size()) != size_) {
+      throw std::invalid_argument("All columns must have the same length");
+    }
+    columns_.push_back(column.data());
+  }
+}
+
+HyperedgeList::HyperedgeList(int size, std::vector<const int *> columns,
+                             std::shared_ptr<const void> owner)
+    : size_(size), columns_(std::move(columns)), owner_(std::move(owner)) {
+  if (size_ < 0) {
+    throw std::invalid_argument("Edge count must be non-negative");
+  }
+}
+
+HyperedgeList
+HyperedgeList::fromRows(int rank, const std::vector<std::vector<int>> &rows) {
+  std::vector<std::vector<int>> columns(rank);
+  for (auto &column : columns) {
+    column.reserve(rows.size());
+  }
+  for (const auto &row : rows) {
+    // ensure all edges have the same rank
+    if (static_cast<int>(row.size()) != rank) {
+      throw std::invalid_argument("All edges must have the same rank");
+    }
+    for (int p = 0; p < rank; ++p) {
+      columns[p].push_back(row[p]);
+    }
+  }
+  return HyperedgeList(std::move(columns));
+}
+
+HyperedgeList
+HyperedgeList::fromPairs(const std::vector<std::pair<int, int>> &edges) {
+  std::vector<std::vector<int>> columns(2);
+  for (auto &column : columns) {
+    column.reserve(edges.size());
+  }
+  for (const auto &[from, to] : edges) {
+    columns[0].push_back(from);
+    columns[1].push_back(to);
+  }
+  return HyperedgeList(std::move(columns));
+}
+
+std::size_t HyperedgeList::getMemoryBytes() const {
+  std::size_t bytes = 0;
+  for (const auto &column : ownedColumns_) {
+    bytes += getVectorBytes(column);
+  }
+  return bytes;
+}
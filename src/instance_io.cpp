@@ -0,0 +1,171 @@
+#include "instance_io.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define INSTANCE_IO_MMAP 1
+#endif
+
+static_assert(sizeof(int) == sizeof(std::int32_t),
+              "The columns are mapped as int");
+
+namespace {
+
+constexpr char kMagic[8] = {'M', 'A', 'T', 'R', 'O', 'I', 'D', 'I'};
+constexpr std::uint32_t kVersion = 1;
+
+struct InstanceHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t type;
+  std::uint32_t rank;
+  std::uint32_t reserved;
+  std::int64_t vertexCount;
+  std::int64_t edgeCount;
+  char padding[24]; // the columns start 64-byte aligned
+};
+static_assert(sizeof(InstanceHeader) == 64, "The header is 64 bytes");
+
+int expectedRank(std::uint32_t type) {
+  switch (static_cast<InstanceType>(type)) {
+  case InstanceType::Bipartite:
+  case InstanceType::Hamiltonian:
+    return 2;
+  case InstanceType::ThreeDMatching:
+    return 3;
+  }
+  throw std::invalid_argument("Instance file has an unknown problem type");
+}
+
+// Checks the header against the file size; returns the edge count
+int checkHeader(const InstanceHeader &header, std::int64_t fileSize) {
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    throw std::invalid_argument("Not an instance file");
+  }
+  if (header.version != kVersion) {
+    throw std::invalid_argument("Unsupported instance file version");
+  }
+  if (static_cast<int>(header.rank) != expectedRank(header.type)) {
+    throw std::invalid_argument("Instance file has the wrong rank");
+  }
+  if (header.vertexCount < 0 || header.vertexCount > INT32_MAX ||
+      header.edgeCount < 0 || header.edgeCount > INT32_MAX) {
+    throw std::invalid_argument("Instance file has invalid counts");
+  }
+  std::int64_t expectedSize =
+      static_cast<std::int64_t>(sizeof(InstanceHeader)) +
+      header.edgeCount * header.rank * std::int64_t{sizeof(std::int32_t)};
+  if (fileSize != expectedSize) {
+    throw std::invalid_argument("Instance file has the wrong size");
+  }
+  return static_cast<int>(header.edgeCount);
+}
+
+void checkVertices(const HyperedgeList &edges, int vertexCount) {
+  for (int p = 0; p < edges.getRank(); p++) {
+    const int *column = edges.getColumn(p);
+    for (int i = 0; i < edges.size(); i++) {
+      if (column[i] < 0 || column[i] >= vertexCount) {
+        throw std::invalid_argument("Instance file has a vertex out of range");
+      }
+    }
+  }
+}
+
+} // namespace
+
+void saveInstance(const std::string &path, const Instance &instance) {
+  const HyperedgeList &edges = *instance.edges;
+  InstanceHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.type = static_cast<std::uint32_t>(instance.type);
+  header.rank = static_cast<std::uint32_t>(edges.getRank());
+  header.vertexCount = instance.vertexCount;
+  header.edgeCount = edges.size();
+  if (static_cast<int>(header.rank) != expectedRank(header.type)) {
+    throw std::invalid_argument("Edges have the wrong rank for the problem");
+  }
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error("Cannot open " + path + " for writing");
+  }
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  for (int p = 0; p < edges.getRank(); p++) {
+    out.write(reinterpret_cast<const char *>(edges.getColumn(p)),
+              static_cast<std::streamsize>(edges.size()) * sizeof(int));
+  }
+  if (!out.flush()) {
+    throw std::runtime_error("Cannot write " + path);
+  }
+}
+
+Instance loadInstance(const std::string &path) {
+  InstanceHeader header;
+  std::shared_ptr<const HyperedgeList> edges;
+#ifdef INSTANCE_IO_MMAP
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open " + path);
+  }
+  struct stat status;
+  if (::fstat(fd, &status) != 0 ||
+      status.st_size < static_cast<off_t>(sizeof(InstanceHeader))) {
+    ::close(fd);
+    throw std::invalid_argument("Not an instance file");
+  }
+  std::size_t fileSize = static_cast<std::size_t>(status.st_size);
+  void *data = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // the mapping keeps the file open
+  if (data == MAP_FAILED) {
+    throw std::runtime_error("Cannot map " + path);
+  }
+  std::shared_ptr<const void> mapping(data, [fileSize](const void *address) {
+    ::munmap(const_cast<void *>(address), fileSize);
+  });
+  std::memcpy(&header, data, sizeof(header));
+  int edgeCount = checkHeader(header, static_cast<std::int64_t>(fileSize));
+  const int *firstColumn = reinterpret_cast<const int *>(
+      static_cast<const char *>(data) + sizeof(InstanceHeader));
+  std::vector<const int *> columns;
+  for (std::uint32_t p = 0; p < header.rank; p++) {
+    columns.push_back(firstColumn + std::size_t{p} * edgeCount);
+  }
+  edges = std::make_shared<const HyperedgeList>(edgeCount, std::move(columns),
+                                                std::move(mapping));
+#else
+  // no mmap: read the columns into memory instead
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in) {
+    throw std::runtime_error("Cannot open " + path);
+  }
+  std::int64_t fileSize = static_cast<std::int64_t>(in.tellg());
+  in.seekg(0);
+  if (fileSize < static_cast<std::int64_t>(sizeof(InstanceHeader)) ||
+      !in.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    throw std::invalid_argument("Not an instance file");
+  }
+  int edgeCount = checkHeader(header, fileSize);
+  std::vector<std::vector<int>> columns(header.rank,
+                                        std::vector<int>(edgeCount));
+  for (auto &column : columns) {
+    in.read(reinterpret_cast<char *>(column.data()),
+            static_cast<std::streamsize>(edgeCount) * sizeof(int));
+  }
+  if (!in) {
+    throw std::runtime_error("Cannot read " + path);
+  }
+  edges = std::make_shared<const HyperedgeList>(std::move(columns));
+#endif
+  int vertexCount = static_cast<int>(header.vertexCount);
+  checkVertices(*edges, vertexCount);
+  return {static_cast<InstanceType>(header.type), vertexCount,
+          std::move(edges)};
+}
@@ -0,0 +1,142 @@
+#include "kernelization.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+std::vector<int>
+MatchingKernel::lift(const std::vector<int> &kernelSolution) const {
+  std::vector<int> solution = forced;
+  for (int element : kernelSolution) {
+    solution.push_back(elements[element]);
+  }
+  std::sort(solution.begin(), solution.end());
+  return solution;
+}
+
+MatchingKernel kernelizeMatching(int vertexPerPartitionCount,
+                                 const HyperedgeList &edges) {
+  int edgesCount = edges.size();
+  int rank = edges.getRank();
+  for (int p = 0; p < rank; p++) {
+    const int *vertexOf = edges.getColumn(p);
+    for (int edge_i = 0; edge_i < edgesCount; edge_i++) {
+      if (vertexOf[edge_i] < 0 || vertexOf[edge_i] >= vertexPerPartitionCount) {
+        throw std::invalid_argument("Vertex index out of bounds");
+      }
+    }
+  }
+  MatchingKernel kernel;
+  std::vector<bool> alive(edgesCount, true);
+
+  // copies are adjacent once sorted by their vertices, the first by index
+  std::vector<int> byVertices(edgesCount);
+  std::iota(byVertices.begin(), byVertices.end(), 0);
+  auto compareVertices = [&edges, rank](int a, int b) {
+    for (int p = 0; p < rank; p++) {
+      int vertexA = edges.getVertex(a, p);
+      int vertexB = edges.getVertex(b, p);
+      if (vertexA != vertexB) {
+        return vertexA < vertexB ? -1 : 1;
+      }
+    }
+    return 0;
+  };
+  std::sort(byVertices.begin(), byVertices.end(),
+            [&compareVertices](int a, int b) {
+              int order = compareVertices(a, b);
+              return order < 0 || (order == 0 && a < b);
+            });
+  for (int i = 1; i < edgesCount; i++) {
+    if (compareVertices(byVertices[i - 1], byVertices[i]) == 0) {
+      alive[byVertices[i]] = false;
+      ++kernel.duplicateCount;
+    }
+  }
+
+  // incidence lists of the distinct edges and their vertices' degrees
+  std::vector<std::vector<int>> degree(
+      rank, std::vector<int>(vertexPerPartitionCount, 0));
+  std::vector<std::vector<int>> offset(
+      rank, std::vector<int>(vertexPerPartitionCount + 1, 0));
+  std::vector<std::vector<int>> incident(rank);
+  for (int p = 0; p < rank; p++) {
+    const int *vertexOf = edges.getColumn(p);
+    for (int edge_i = 0; edge_i < edgesCount; edge_i++) {
+      if (alive[edge_i]) {
+        ++degree[p][vertexOf[edge_i]];
+      }
+    }
+    std::partial_sum(degree[p].begin(), degree[p].end(),
+                     offset[p].begin() + 1);
+    incident[p].resize(offset[p].back());
+    std::vector<int> fill(offset[p].begin(), offset[p].end() - 1);
+    for (int edge_i = 0; edge_i < edgesCount; edge_i++) {
+      if (alive[edge_i]) {
+        incident[p][fill[vertexOf[edge_i]]++] = edge_i;
+      }
+    }
+  }
+
+  // an edge is forced once at most one of its vertices has another edge; a
+  // vertex whose degree drops to 1 makes its last edge a candidate again
+  auto isForced = [&](int element) {
+    int shared = 0;
+    for (int p = 0; p < rank; p++) {
+      if (degree[p][edges.getVertex(element, p)] > 1 && ++shared > 1) {
+        return false;
+      }
+    }
+    return true;
+  };
+  std::vector<int> candidates;
+  for (int edge_i = 0; edge_i < edgesCount; edge_i++) {
+    if (alive[edge_i]) {
+      candidates.push_back(edge_i);
+    }
+  }
+  auto drop = [&](int element) {
+    alive[element] = false;
+    for (int p = 0; p < rank; p++) {
+      int vertex = edges.getVertex(element, p);
+      if (--degree[p][vertex] == 1) {
+        for (int i = offset[p][vertex]; i < offset[p][vertex + 1]; i++) {
+          if (alive[incident[p][i]]) {
+            candidates.push_back(incident[p][i]);
+            break;
+          }
+        }
+      }
+    }
+  };
+  for (std::size_t head = 0; head < candidates.size(); head++) {
+    int element = candidates[head];
+    if (!alive[element] || !isForced(element)) {
+      continue;
+    }
+    kernel.forced.push_back(element);
+    alive[element] = false;
+    for (int p = 0; p < rank; p++) {
+      int vertex = edges.getVertex(element, p);
+      --degree[p][vertex];
+      for (int i = offset[p][vertex]; i < offset[p][vertex + 1]; i++) {
+        if (alive[incident[p][i]]) {
+          drop(incident[p][i]);
+          ++kernel.droppedCount;
+        }
+      }
+    }
+  }
+  std::sort(kernel.forced.begin(), kernel.forced.end());
+
+  std::vector<std::vector<int>> columns(rank);
+  for (int edge_i = 0; edge_i < edgesCount; edge_i++) {
+    if (alive[edge_i]) {
+      kernel.elements.push_back(edge_i);
+      for (int p = 0; p < rank; p++) {
+        columns[p].push_back(edges.getVertex(edge_i, p));
+      }
+    }
+  }
+  kernel.edges = std::make_shared<const HyperedgeList>(std::move(columns));
+  return kernel;
+}
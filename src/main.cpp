@@ -1,249 +1,1121 @@
+#include "command_line_options.h"
+#include "component_decomposition.h"
+#include "deadline.h"
 #include "graph_generator.h"
+#include "instance_io.h"
+#include "kernelization.h"
 #include "matroid_implementations.h"
 #include "matroid_intersection.h"
 #include "matroid_problem.h"
+#include "memory_usage.h"
+#include "result_writer.h"
 #include "validation.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <set>
+#include <sstream>
+#include <stdexcept>
 #include <string>
-#include <type_traits>
+#include <thread>
 #include <vector>
 
-// Helper function to convert graph edges to JSON
-template <typename EdgeType>
-nlohmann::json graphToJson(const std::vector<EdgeType> &edges) {
-  nlohmann::json graphJson = nlohmann::json::array();
-  for (const auto &edge : edges) {
-    if constexpr (std::is_same_v<EdgeType, std::vector<int>>) {
-      // Hyperedge (vector of ints)
-      graphJson.push_back(edge);
-    } else if constexpr (std::is_same_v<EdgeType, std::pair<int, int>>) {
-      // Regular edge (pair)
-      graphJson.push_back({edge.first, edge.second});
-    }
+// --sampling=percandidate (default, one draw per candidate edge) or
+// --sampling=geometric (skips straight to the next kept edge)
+GraphGenerator::SamplingMode
+getSamplingMode(const CommandLineOptions &options) {
+  std::string mode = options.getString("sampling", "percandidate");
+  if (mode == "percandidate") {
+    return GraphGenerator::SamplingMode::PerCandidate;
+  }
+  if (mode == "geometric") {
+    return GraphGenerator::SamplingMode::GeometricSkip;
   }
-  return graphJson;
+  throw std::invalid_argument("Unknown sampling mode: " + mode);
 }
 
-// Helper function to add a solution to JSON output
-void addSolutionToJson(nlohmann::json &output, const std::string &algorithm,
-                       const ApproximationSolution &solution) {
+// A solution tagged with the algorithm that produced it
+struct NamedSolution {
+  std::string algorithm;
+  ApproximationSolution solution;
+  nlohmann::json statistics = nullptr; // extra fields of the run, if any
+};
+
+nlohmann::json solutionToJson(const NamedSolution &result) {
   nlohmann::json solutionJson;
-  solutionJson["algorithm"] = algorithm;
-  solutionJson["approxRatio"] = solution.getApproximationRatio();
-  solutionJson["solution"] = solution.getSolution();
-  output["solutions"].push_back(solutionJson);
+  solutionJson["algorithm"] = result.algorithm;
+  solutionJson["approxRatio"] = result.solution.getApproximationRatio();
+  solutionJson["solution"] = result.solution.getSolution();
+  if (!result.statistics.is_null()) {
+    solutionJson["statistics"] = result.statistics;
+  }
+  return solutionJson;
 }
 
-// Helper function to add multiple solutions to JSON output
-void addSolutionsToJson(nlohmann::json &output, const std::string &algorithm,
-                        const std::vector<ApproximationSolution> &solutions) {
-  for (const auto &solution : solutions) {
-    addSolutionToJson(output, algorithm, solution);
+// The solutions of a run, in output order: each one is validated and written
+// as soon as its algorithm returns it, with its "weight" if the instance is
+// weighted
+class AlgorithmResults {
+public:
+  using Validator = std::function<void(const std::vector<int> &)>;
+
+  AlgorithmResults(ResultWriter &writer, Validator validate,
+                   ElementWeights weights = {})
+      : writer_(writer), validate_(std::move(validate)),
+        weights_(std::move(weights)) {}
+
+  void add(const NamedSolution &result) {
+    validate_(result.solution.getSolution());
+    nlohmann::json solutionJson = solutionToJson(result);
+    if (weights_) {
+      solutionJson["weight"] =
+          getSetWeight(weights_, result.solution.getSolution());
+    }
+    writer_.addSolution(solutionJson);
   }
-}
 
-// Helper function to run baseline and local search algorithms
-struct AlgorithmResults {
-  ApproximationSolution baseline;
-  std::vector<ApproximationSolution> localSearch;
+private:
+  ResultWriter &writer_;
+  Validator validate_;
+  ElementWeights weights_;
 };
 
-// Helper function to build final JSON output
-nlohmann::json
-buildOutputJson(const std::string &problemName, const nlohmann::json &graphJson,
-                const AlgorithmResults &results,
-                const ApproximationSolution *kuhnResult = nullptr) {
-  nlohmann::json output;
-  output["problem_name"] = problemName;
-  output["graph"] = graphJson;
-  output["solutions"] = nlohmann::json::array();
+// In a build with MATROID_ORACLE_COUNTERS, adds the oracle counters of the
+// problem since its last resetOracleCounters to the statistics of result
+void addOracleCounters(NamedSolution &result, const OracleCounters &counters) {
+  if constexpr (kOracleCountersEnabled) {
+    nlohmann::json matroids = nlohmann::json::array();
+    for (const auto &matroid : counters.matroids) {
+      matroids.push_back(
+          {{"canAddCalls", matroid.canAddCalls},
+           {"canAddRejections", matroid.canAddRejections},
+           {"canExchangeCalls", matroid.canExchangeCalls},
+           {"canExchangeRejections", matroid.canExchangeRejections}});
+    }
+    if (result.statistics.is_null()) {
+      result.statistics = nlohmann::json::object();
+    }
+    result.statistics["oracleCounters"] = {
+        {"matroids", matroids},
+        {"additions", counters.additions},
+        {"removals", counters.removals},
+        {"rejectedAdditions", counters.rejectedAdditions},
+        {"undoAdditions", counters.undoAdditions},
+        {"undoRemovals", counters.undoRemovals}};
+  }
+}
 
-  addSolutionToJson(output, "baseline", results.baseline);
+// A local search trace as columns of equal length, one entry per
+// improvement, which is compact and loads directly into a data frame
+nlohmann::json traceToJson(const std::vector<LocalSearchTraceEntry> &trace) {
+  nlohmann::json seconds = nlohmann::json::array();
+  nlohmann::json steps = nlohmann::json::array();
+  nlohmann::json removals = nlohmann::json::array();
+  nlohmann::json insertions = nlohmann::json::array();
+  nlohmann::json solutionSizes = nlohmann::json::array();
+  nlohmann::json candidateChecks = nlohmann::json::array();
+  for (const auto &entry : trace) {
+    seconds.push_back(entry.seconds);
+    steps.push_back(entry.step);
+    removals.push_back(entry.removals);
+    insertions.push_back(entry.insertions);
+    solutionSizes.push_back(entry.solutionSize);
+    candidateChecks.push_back(entry.candidateChecks);
+  }
+  return {{"seconds", seconds},
+          {"step", steps},
+          {"removals", removals},
+          {"insertions", insertions},
+          {"solutionSize", solutionSizes},
+          {"candidateChecks", candidateChecks}};
+}
 
-  if (kuhnResult) {
-    addSolutionToJson(output, "kuhn", *kuhnResult);
+// --order=<index|mindegree|random|fewestconflicts>: the order in which the
+// baseline scans the elements, index (as generated) by default
+ElementOrdering getElementOrdering(const CommandLineOptions &options) {
+  return parseElementOrdering(options.getString("order", "index"));
+}
+
+// Helper function to run the baseline algorithm in the --order of the
+// elements, whose vertices are the columns of edges (n per partition), a
+// random order drawn from seed; returns its solution
+template <typename Problem>
+std::vector<int>
+runBaseline(const std::shared_ptr<Problem> &problem, int n,
+            const std::shared_ptr<const HyperedgeList> &edges,
+            unsigned int seed, const Deadline &deadline,
+            const CommandLineOptions &options, AlgorithmResults &results) {
+  problem->resetOracleCounters();
+  BasicBaselineAlgorithm baseline(problem);
+  baseline.setDeadline(deadline);
+  ElementOrdering ordering = getElementOrdering(options);
+  nlohmann::json statistics = nullptr;
+  if (ordering != ElementOrdering::Index) {
+    baseline.setElementOrder(computeElementOrder(ordering, n, edges, seed));
+    statistics = {{"order", getElementOrderingName(ordering)}};
   }
+  NamedSolution result{"baseline", baseline.run(), statistics};
+  addOracleCounters(result, problem->getOracleCounters());
+  results.add(result);
+  problem->reset();
+  return result.solution.getSolution();
+}
 
-  addSolutionsToJson(output, "localsearch", results.localSearch);
+// --start=empty (default) or --start=baseline: whether local search starts
+// from the baseline solution instead of the empty set
+bool startsFromBaseline(const CommandLineOptions &options) {
+  std::string start = options.getString("start", "empty");
+  if (start == "empty") {
+    return false;
+  }
+  if (start == "baseline") {
+    return true;
+  }
+  throw std::invalid_argument("Unknown start: " + start);
+}
+
+// --search=exhaustive (default), sampling or both: whether local search
+// enumerates the exchanges, samples them, or does both at the same time
+// limit, for a comparison
+enum class SearchMode { Exhaustive, Sampling, Both };
 
-  return output;
+SearchMode getSearchMode(const CommandLineOptions &options) {
+  std::string mode = options.getString("search", "exhaustive");
+  if (mode == "exhaustive") {
+    return SearchMode::Exhaustive;
+  }
+  if (mode == "sampling") {
+    return SearchMode::Sampling;
+  }
+  if (mode == "both") {
+    return SearchMode::Both;
+  }
+  throw std::invalid_argument("Unknown search mode: " + mode);
 }
 
-// Parse command line arguments and run experiments
-int main(int argc, char *argv[]) {
-  try {
-    if (argc < 2) {
-      std::cerr << "Usage: " << argv[0] << " <command> [args...]" << std::endl;
-      std::cerr << "Commands:" << std::endl;
-      std::cerr << "  bipartite <n> <p> [seed] [timeLimit]" << std::endl;
-      std::cerr << "  3dmatching <n> <p> [seed] [timeLimit]" << std::endl;
-      std::cerr << "  hamiltonian <n> <p> [minHamiltonianPathLength] [seed] "
-                   "[timeLimit]"
-                << std::endl;
-      return 1;
+// Helper function to run the sampling local search from initialSolution on
+// the reset problem, with the --max-removals, --annealing, --cooling and
+// --restart-interval options; exhaustiveSize, unless -1, is the size the
+// exhaustive search reached in the same time
+template <typename Problem>
+void runSamplingSearch(
+    const std::shared_ptr<Problem> &problem,
+    std::chrono::milliseconds timeLimit, const Deadline &deadline,
+    unsigned int seed, const CommandLineOptions &options,
+    AlgorithmResults &results, std::vector<int> initialSolution,
+    const std::shared_ptr<const PartitionConflictIndex> &conflictIndex,
+    int exhaustiveSize) {
+  problem->reset();
+  problem->resetOracleCounters();
+  BasicSamplingLocalSearchAlgorithm sampling(problem, timeLimit, seed);
+  sampling.setMaxRemovals(options.getInt("max-removals", 3));
+  sampling.setAnnealing(options.getDouble("annealing", 0),
+                        options.getDouble("cooling", 0.9999));
+  sampling.setRestartInterval(options.getInt("restart-interval", 100000));
+  sampling.setConflictIndex(conflictIndex);
+  sampling.setInitialSolution(std::move(initialSolution));
+  sampling.setDeadline(deadline);
+  auto solution = sampling.run();
+  nlohmann::json statistics = {
+      {"samples", sampling.getSampleCount()},
+      {"samplesPerSecond", sampling.getSamplesPerSecond()},
+      {"improvements", sampling.getImprovementCount()},
+      {"plateauMoves", sampling.getPlateauMoveCount()},
+      {"restarts", sampling.getRestartCount()},
+      {"elapsedSeconds", sampling.getElapsedSeconds()}};
+  if (exhaustiveSize >= 0) {
+    statistics["exhaustiveSolutionSize"] = exhaustiveSize;
+  }
+  NamedSolution result{"samplingsearch", solution, statistics};
+  addOracleCounters(result, problem->getOracleCounters());
+  results.add(result);
+}
+
+// Helper function to run local search from the --start solution; with
+// --threads=N (N > 1) it runs as a multi-start search instead, and with
+// --search=sampling or both the sampling search replaces or follows it
+template <typename Problem>
+void runLocalSearch(
+    const std::shared_ptr<Problem> &problem,
+    std::chrono::milliseconds timeLimit, const Deadline &deadline,
+    unsigned int seed, const CommandLineOptions &options,
+    AlgorithmResults &results,
+    const std::vector<int> &baseline,
+    const std::shared_ptr<const PartitionConflictIndex> &conflictIndex = {}) {
+  int threadCount = options.getInt("threads", 1);
+  std::vector<int> initialSolution;
+  if (startsFromBaseline(options)) {
+    initialSolution = baseline;
+  }
+  SearchMode mode = getSearchMode(options);
+  if (mode == SearchMode::Sampling) {
+    runSamplingSearch(problem, timeLimit, deadline, seed, options, results,
+                      std::move(initialSolution), conflictIndex, -1);
+    return;
+  }
+  int exhaustiveSize = 0;
+  problem->resetOracleCounters();
+  if (threadCount > 1) {
+    BasicParallelLocalSearchAlgorithm multiStart(problem, timeLimit,
+                                                 threadCount, seed);
+    multiStart.setConflictIndex(conflictIndex);
+    multiStart.setInitialSolution(initialSolution);
+    multiStart.setDeadline(deadline);
+    auto solution = multiStart.run();
+    exhaustiveSize = solution.getSolution().size();
+    nlohmann::json threads = nlohmann::json::array();
+    for (const auto &statistics : multiStart.getThreadStatistics()) {
+      threads.push_back({{"seed", statistics.seed},
+                         {"solutionSize", statistics.solutionSize},
+                         {"completedSteps", statistics.completedSteps},
+                         {"approxRatio", statistics.approximationRatio},
+                         {"elapsedSeconds", statistics.elapsedSeconds},
+                         {"trace", traceToJson(statistics.trace)}});
+    }
+    NamedSolution result{"multistart", solution, {{"threads", threads}}};
+    addOracleCounters(result, problem->getOracleCounters());
+    results.add(result);
+  } else {
+    BasicLocalSearchAlgorithm localSearch(problem, timeLimit);
+    localSearch.setThreadCount(options.getInt("search-threads", 1));
+    localSearch.setConflictIndex(conflictIndex);
+    localSearch.setInitialSolution(initialSolution);
+    localSearch.setDeadline(deadline);
+    auto solutions = localSearch.run();
+    if (!solutions.empty()) {
+      exhaustiveSize = solutions.back().getSolution().size();
+    }
+    for (size_t i = 0; i < solutions.size(); i++) {
+      NamedSolution result{"localsearch", std::move(solutions[i])};
+      // the trace and the counters cover the whole run, which ends with the
+      // last solution
+      if (i + 1 == solutions.size()) {
+        result.statistics = {{"trace", traceToJson(localSearch.getTrace())},
+                             {"stepSeconds", localSearch.getStepSeconds()}};
+        addOracleCounters(result, problem->getOracleCounters());
+      }
+      results.add(result);
     }
+  }
+  if (mode == SearchMode::Both) {
+    runSamplingSearch(problem, timeLimit, deadline, seed, options, results,
+                      std::move(initialSolution), conflictIndex,
+                      exhaustiveSize);
+  }
+}
 
-    std::string command = argv[1];
+// On a weighted problem, the weighted greedy and then the weighted local
+// search, from the --start solution (the weighted greedy one for baseline)
+template <typename Problem>
+void runWeighted(
+    const std::shared_ptr<Problem> &problem,
+    std::chrono::milliseconds timeLimit, const Deadline &deadline,
+    const CommandLineOptions &options, AlgorithmResults &results,
+    const std::shared_ptr<const PartitionConflictIndex> &conflictIndex) {
+  if (!problem->isWeighted()) {
+    return;
+  }
+  problem->reset(); // local search leaves its solution in the problem
+  problem->resetOracleCounters();
+  BasicBaselineAlgorithm greedy(problem);
+  greedy.setElementOrder(orderByDecreasingWeight(*problem->getWeights()));
+  greedy.setDeadline(deadline);
+  NamedSolution greedyResult{"weightedbaseline", greedy.run()};
+  addOracleCounters(greedyResult, problem->getOracleCounters());
+  results.add(greedyResult);
+  problem->reset();
 
-    if (command == "bipartite" && argc >= 4) {
-      int n = std::stoi(argv[2]);
-      double p = std::stod(argv[3]);
-      unsigned int seed = (argc >= 5) ? std::stoul(argv[4]) : 42;
-      int timeLimit = (argc >= 6) ? std::stoi(argv[5]) : 10;
+  problem->resetOracleCounters();
+  BasicWeightedLocalSearchAlgorithm localSearch(problem, conflictIndex,
+                                                timeLimit);
+  if (startsFromBaseline(options)) {
+    localSearch.setInitialSolution(greedyResult.solution.getSolution());
+  }
+  localSearch.setDeadline(deadline);
+  auto solution = localSearch.run();
+  NamedSolution result{
+      "weightedlocalsearch",
+      solution,
+      {{"improvements", localSearch.getImprovementCount()},
+       {"gainEvaluations", localSearch.getGainEvaluationCount()},
+       {"rounds", localSearch.getRoundCount()}}};
+  addOracleCounters(result, problem->getOracleCounters());
+  results.add(result);
+}
 
-      // Generate random bipartite graph
-      GraphGenerator gen(seed);
-      auto edgePairs = gen.generateErdosRenyiBipartite(n, p);
-      std::cerr << "Generated " << edgePairs.size() << " edges" << std::endl;
+// The "memory" part of the output: the bytes of each subsystem's data
+// structures at their high-water mark (memory_usage.h), sharing storage
+// counted once, and the resident set size of the process. The subsystems
+// are those that live for the whole run; the transient problem clones of
+// the threaded searches and the component and kernel problems only show in
+// the peak resident set size
+nlohmann::json memoryReport(const nlohmann::json &subsystems) {
+  ProcessMemory process = getProcessMemory();
+  return {{"currentBytes", process.currentBytes},
+          {"peakBytes", process.peakBytes},
+          {"subsystems", subsystems}};
+}
 
-      // Convert pairs to vectors for MatchingProblem (2-uniform hypergraph)
-      std::vector<std::vector<int>> edges;
-      edges.reserve(edgePairs.size());
-      for (const auto &pair : edgePairs) {
-        edges.push_back({pair.first, pair.second});
-      }
+std::size_t getWeightsBytes(const ElementWeights &weights) {
+  return weights ? getVectorBytes(*weights) : 0;
+}
 
-      // Create MatchingProblem for 2-uniform hypergraph (bipartite matching)
-      auto matchingProblem = std::make_shared<MatchingProblem>(2, n, edges);
+// With --component-threads=N (N >= 1), the baseline and local search again
+// on the connected components of the edges, each a separate problem built by
+// makeProblem, solved on N threads and merged: "componentbaseline" and
+// "componentlocalsearch". One time limit covers all the components, split
+// among them by size; with partitionIndex, each local search gets its
+// component's conflict index. A component whose search returns less than its
+// greedy solution, e.g. as it ran out of time, keeps the greedy one.
+template <typename MakeProblem>
+void runComponents(int n, const std::shared_ptr<const HyperedgeList> &edges,
+                   ComponentVertices vertices, bool partitionIndex,
+                   const MakeProblem &makeProblem,
+                   std::chrono::milliseconds timeLimit,
+                   const Deadline &deadline,
+                   const CommandLineOptions &options,
+                   AlgorithmResults &results) {
+  int threadCount = options.getInt("component-threads", 0);
+  if (threadCount <= 0) {
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::vector<GraphComponent> components =
+      decomposeIntoComponents(n, *edges, vertices);
+  double decompositionSeconds = std::chrono::duration<double>(
+                                    std::chrono::steady_clock::now() - start)
+                                    .count();
+  std::size_t largest = 0;
+  for (const auto &component : components) {
+    largest = std::max(largest, component.elements.size());
+  }
+  nlohmann::json statistics = {{"components", components.size()},
+                               {"largestComponent", largest},
+                               {"threads", threadCount},
+                               {"decompositionSeconds", decompositionSeconds}};
 
-      // Run baseline algorithm
-      BaselineAlgorithm baseline(matchingProblem);
-      auto baselineResult = baseline.run();
+  // the greedy solution of each component, the fallback of its local search
+  std::vector<ApproximationSolution> greedySolutions(
+      components.size(), ApproximationSolution(0.0, {}));
+  auto baseline = solveComponents(
+      components, threadCount, [&](const GraphComponent &component) {
+        BasicBaselineAlgorithm greedy(makeProblem(component));
+        greedy.setDeadline(deadline);
+        auto solution = greedy.run();
+        greedySolutions[&component - components.data()] = solution;
+        return solution;
+      });
+  results.add({"componentbaseline", baseline, statistics});
 
-      // Reset and run Kuhn 2D matching algorithm
-      matchingProblem->reset();
-      Kuhn2dMatchingAlgorithm kuhn(matchingProblem);
-      auto kuhnResult = kuhn.run();
+  // each component gets the share of the time limit of its elements, times
+  // the threads running components side by side
+  double shareScale =
+      static_cast<double>(timeLimit.count()) *
+      std::min<std::size_t>(threadCount, components.size()) /
+      std::max<std::size_t>(1, edges->size());
+  Deadline searchDeadline = deadline.within(timeLimit);
+  auto localSearch = solveComponents(
+      components, threadCount, [&](const GraphComponent &component) {
+        auto share = std::min(
+            timeLimit, std::chrono::milliseconds(std::max<long long>(
+                           1, std::llround(shareScale *
+                                           component.elements.size()))));
+        BasicLocalSearchAlgorithm search(makeProblem(component), share);
+        search.setDeadline(searchDeadline);
+        if (partitionIndex) {
+          search.setConflictIndex(std::make_shared<PartitionConflictIndex>(
+              component.vertexCount, component.edges));
+        }
+        search.setVerbose(false);
+        auto solutions = search.run();
+        const auto &greedy = greedySolutions[&component - components.data()];
+        if (solutions.empty() || solutions.back().getSolution().size() <
+                                     greedy.getSolution().size()) {
+          return greedy;
+        }
+        return solutions.back();
+      });
+  if (localSearch.getSolution().size() < baseline.getSolution().size()) {
+    throw std::logic_error(
+        "Component local search found less than the component baseline");
+  }
+  results.add({"componentlocalsearch", localSearch, statistics});
+}
 
-      // Reset and run local search algorithm
-      matchingProblem->reset();
-      LocalSearchAlgorithm localSearch(matchingProblem, timeLimit);
-      auto localSearchSolutions = localSearch.run();
+// With --kernelize, the baseline and local search again on the kernel of
+// the matching instance (kernelization.h), a problem built by makeProblem,
+// and lifted back to the instance: "kernelbaseline" and "kernellocalsearch"
+template <typename MakeProblem>
+void runKernel(int n, const std::shared_ptr<const HyperedgeList> &edges,
+               const MakeProblem &makeProblem,
+               std::chrono::milliseconds timeLimit, const Deadline &deadline,
+               const CommandLineOptions &options, AlgorithmResults &results) {
+  if (!options.named.count("kernelize")) {
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  MatchingKernel kernel = kernelizeMatching(n, *edges);
+  double kernelSeconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  nlohmann::json statistics = {{"kernelSize", kernel.elements.size()},
+                               {"forced", kernel.forced.size()},
+                               {"duplicates", kernel.duplicateCount},
+                               {"dropped", kernel.droppedCount},
+                               {"kernelSeconds", kernelSeconds}};
+  auto problem = makeProblem(n, kernel.edges);
 
-      // Validate all solutions before outputting
-      validate_bipartite_matching(n, edgePairs, baselineResult.getSolution());
-      validate_bipartite_matching(n, edgePairs, kuhnResult.getSolution());
-      for (const auto &solution : localSearchSolutions) {
-        validate_bipartite_matching(n, edgePairs, solution.getSolution());
-      }
+  BasicBaselineAlgorithm baseline(problem);
+  baseline.setDeadline(deadline);
+  auto baselineSolution = baseline.run();
+  results.add({"kernelbaseline",
+               ApproximationSolution(
+                   baselineSolution.getApproximationRatio(),
+                   kernel.lift(baselineSolution.getSolution())),
+               statistics});
+  problem->reset();
 
-      // Build JSON output using helper functions
-      auto graphJson = graphToJson(edges);
-      AlgorithmResults results{baselineResult, localSearchSolutions};
-      auto output =
-          buildOutputJson("BIPARTITE", graphJson, results, &kuhnResult);
-
-      std::cout << output.dump() << std::endl;
-
-    } else if (command == "3dmatching" && argc >= 4) {
-      int n = std::stoi(argv[2]);
-      double p = std::stod(argv[3]);
-      unsigned int seed = (argc >= 5) ? std::stoul(argv[4]) : 42;
-      int timeLimit = (argc >= 6) ? std::stoi(argv[5]) : 10;
-
-      // Generate 3D matching instance using tripartite hypergraph
-      GraphGenerator gen(seed);
-      auto hyperedges = gen.generate3DGraph(n, p);
-      std::cerr << "Generated " << hyperedges.size() << " hyperedges"
-                << std::endl;
-
-      // Create MatchingProblem for 3-uniform hypergraph (3D matching)
-      auto matchingProblem =
-          std::make_shared<MatchingProblem>(3, n, hyperedges);
-
-      // Run baseline algorithm
-      BaselineAlgorithm baseline(matchingProblem);
-      auto baselineResult = baseline.run();
-
-      // Reset problem and run local search
-      matchingProblem->reset();
-      LocalSearchAlgorithm localSearch(matchingProblem, timeLimit);
-      auto localSearchResults = localSearch.run();
-
-      AlgorithmResults results{baselineResult, localSearchResults};
-
-      // Validate all solutions before outputting
-      validate_3d_matching(n, hyperedges, baselineResult.getSolution());
-      for (const auto &solution : localSearchResults) {
-        validate_3d_matching(n, hyperedges, solution.getSolution());
-      }
+  BasicLocalSearchAlgorithm localSearch(problem, timeLimit);
+  localSearch.setConflictIndex(
+      std::make_shared<PartitionConflictIndex>(n, kernel.edges));
+  localSearch.setDeadline(deadline);
+  auto solutions = localSearch.run();
+  if (!solutions.empty()) {
+    results.add({"kernellocalsearch",
+                 ApproximationSolution(
+                     solutions.back().getApproximationRatio(),
+                     kernel.lift(solutions.back().getSolution())),
+                 statistics});
+  }
+}
+
+// Every algorithm on a bipartite matching instance, written to writer
+void solveBipartite(int n, const std::shared_ptr<const HyperedgeList> &edges,
+                    const ElementWeights &weights, unsigned int seed,
+                    std::chrono::milliseconds timeLimit,
+                    const Deadline &deadline,
+                    const CommandLineOptions &options, ResultWriter &writer) {
+  writer.begin("BIPARTITE",
+               [&edges](std::ostream &out) { writeEdges(out, *edges); });
+  auto validator = std::make_shared<MatchingValidator>(n, edges, 2);
+  AlgorithmResults results(
+      writer,
+      [validator](const std::vector<int> &s) { validator->validate(s); },
+      weights);
+
+  // Create MatchingProblem for 2-uniform hypergraph (bipartite matching);
+  // every problem and index below shares the same edge columns
+  auto matchingProblem = std::make_shared<MatchingProblem>(n, edges);
+  auto staticProblem = std::make_shared<StaticBipartiteMatchingProblem>(
+      makeStaticBipartiteMatchingProblem(n, edges));
+  staticProblem->setWeights(weights);
+  auto conflictIndex = std::make_shared<PartitionConflictIndex>(n, edges);
+
+  // Run baseline algorithm
+  std::vector<int> baseline = runBaseline(staticProblem, n, edges, seed,
+                                          deadline, options, results);
+
+  // Run Kuhn 2D matching algorithm
+  Kuhn2dMatchingAlgorithm kuhn(matchingProblem);
+  kuhn.setDeadline(deadline);
+  results.add({"kuhn", kuhn.run()});
+
+  // Run Hopcroft-Karp algorithm
+  HopcroftKarpMatchingAlgorithm hopcroftKarp(matchingProblem);
+  hopcroftKarp.setDeadline(deadline);
+  auto hopcroftKarpResult = hopcroftKarp.run();
+  results.add({"hopcroftkarp", hopcroftKarpResult,
+               {{"phases", hopcroftKarp.getPhaseCount()}}});
+
+  // Run the general exact two-matroid intersection algorithm; it queries
+  // the matroids directly, so only its additions and removals are counted
+  matchingProblem->resetOracleCounters();
+  ExchangeGraphIntersectionAlgorithm exchange(matchingProblem);
+  exchange.setDeadline(deadline);
+  auto exchangeResult = exchange.run();
+  NamedSolution exchangeSolution{
+      "exchange",
+      exchangeResult,
+      {{"phases", exchange.getPhaseCount()},
+       {"augmentations", exchange.getAugmentationCount()}}};
+  addOracleCounters(exchangeSolution, matchingProblem->getOracleCounters());
+  results.add(exchangeSolution);
+
+  // Run local search algorithm
+  runLocalSearch(staticProblem, timeLimit, deadline, seed, options, results,
+                 baseline, conflictIndex);
+  runWeighted(staticProblem, timeLimit, deadline, options, results,
+              conflictIndex);
+  runComponents(
+      n, edges, ComponentVertices::PerPartition, true,
+      [](const GraphComponent &component) {
+        return std::make_shared<StaticBipartiteMatchingProblem>(
+            makeStaticBipartiteMatchingProblem(component.vertexCount,
+                                               component.edges));
+      },
+      timeLimit, deadline, options, results);
+  runKernel(
+      n, edges,
+      [](int vertexCount,
+         const std::shared_ptr<const HyperedgeList> &kernelEdges) {
+        return std::make_shared<StaticBipartiteMatchingProblem>(
+            makeStaticBipartiteMatchingProblem(vertexCount, kernelEdges));
+      },
+      timeLimit, deadline, options, results);
+
+  writer.end(memoryReport(
+      {{"graph", edges->getMemoryBytes()},
+       {"weights", getWeightsBytes(weights)},
+       {"matchingProblem", matchingProblem->getMemoryBytes()},
+       {"problem", staticProblem->getMemoryBytes()},
+       {"conflictIndex", conflictIndex->getMemoryBytes() +
+                             conflictIndex->getSharedMemoryBytes()},
+       {"validator", validator->getMemoryBytes()}}));
+}
+
+// Every algorithm on a 3D matching instance, written to writer
+void solve3DMatching(int n,
+                     const std::shared_ptr<const HyperedgeList> &hyperedges,
+                     const ElementWeights &weights, unsigned int seed,
+                     std::chrono::milliseconds timeLimit,
+                     const Deadline &deadline,
+                     const CommandLineOptions &options, ResultWriter &writer) {
+  writer.begin("3DMATCHING", [&hyperedges](std::ostream &out) {
+    writeEdges(out, *hyperedges);
+  });
+  auto validator = std::make_shared<MatchingValidator>(n, hyperedges, 3);
+  AlgorithmResults results(
+      writer,
+      [validator](const std::vector<int> &s) { validator->validate(s); },
+      weights);
+
+  // Create the 3-uniform hypergraph matching problem (3D matching)
+  auto matchingProblem = std::make_shared<Static3DMatchingProblem>(
+      makeStatic3DMatchingProblem(n, hyperedges));
+  matchingProblem->setWeights(weights);
+  auto conflictIndex = std::make_shared<PartitionConflictIndex>(n, hyperedges);
+
+  // Run baseline algorithm, then local search on the reset problem
+  std::vector<int> baseline = runBaseline(matchingProblem, n, hyperedges, seed,
+                                          deadline, options, results);
+  runLocalSearch(matchingProblem, timeLimit, deadline, seed, options, results,
+                 baseline, conflictIndex);
+  runWeighted(matchingProblem, timeLimit, deadline, options, results,
+              conflictIndex);
+  runComponents(
+      n, hyperedges, ComponentVertices::PerPartition, true,
+      [](const GraphComponent &component) {
+        return std::make_shared<Static3DMatchingProblem>(
+            makeStatic3DMatchingProblem(component.vertexCount,
+                                        component.edges));
+      },
+      timeLimit, deadline, options, results);
+  runKernel(
+      n, hyperedges,
+      [](int vertexCount,
+         const std::shared_ptr<const HyperedgeList> &kernelEdges) {
+        return std::make_shared<Static3DMatchingProblem>(
+            makeStatic3DMatchingProblem(vertexCount, kernelEdges));
+      },
+      timeLimit, deadline, options, results);
+
+  writer.end(memoryReport(
+      {{"graph", hyperedges->getMemoryBytes()},
+       {"weights", getWeightsBytes(weights)},
+       {"problem", matchingProblem->getMemoryBytes()},
+       {"conflictIndex", conflictIndex->getMemoryBytes() +
+                             conflictIndex->getSharedMemoryBytes()},
+       {"validator", validator->getMemoryBytes()}}));
+}
+
+// Every algorithm on a Hamiltonian path instance, written to writer; edges
+// are (from, to) columns
+void solveHamiltonian(int n, const std::shared_ptr<const HyperedgeList> &edges,
+                      const ElementWeights &weights, unsigned int seed,
+                      std::chrono::milliseconds timeLimit,
+                      const Deadline &deadline,
+                      const CommandLineOptions &options, ResultWriter &writer) {
+  writer.begin("HAMILTONIAN",
+               [&edges](std::ostream &out) { writeEdges(out, *edges); });
+  auto validator = std::make_shared<HamiltonianPathValidator>(n, edges);
+  AlgorithmResults results(
+      writer,
+      [validator](const std::vector<int> &s) { validator->validate(s); },
+      weights);
+
+  // Create the Hamiltonian path problem; its three matroids share the edge
+  // columns
+  auto hamiltonianProblem = std::make_shared<StaticHamiltonianPathProblem>(
+      makeStaticHamiltonianPathProblem(n, edges));
+  hamiltonianProblem->setWeights(weights);
 
-      // Build JSON output using helper functions
-      auto graphJson = graphToJson(hyperedges);
-      auto output = buildOutputJson("3DMATCHING", graphJson, results);
-
-      std::cout << output.dump() << std::endl;
-
-    } else if (command == "hamiltonian" && argc >= 4) {
-      int n = std::stoi(argv[2]);
-      double p = std::stod(argv[3]);
-
-      // Parse optional minHamiltonianPathLength, seed, and timeLimit
-      // Format: hamiltonian <n> <p> [minHamiltonianPathLength] [seed]
-      // [timeLimit]
-      int minHamiltonianPathLength = 0;
-      unsigned int seed = 42;
-      int timeLimit = 10;
-
-      if (argc >= 5) {
-        if (argc >= 6) {
-          if (argc >= 7) {
-            // All three optional parameters provided
-            minHamiltonianPathLength = std::stoi(argv[4]);
-            seed = std::stoul(argv[5]);
-            timeLimit = std::stoi(argv[6]);
-          } else {
-            // minHamiltonianPathLength and seed provided
-            minHamiltonianPathLength = std::stoi(argv[4]);
-            seed = std::stoul(argv[5]);
-          }
+  // Run baseline algorithm, then local search on the reset problem
+  std::vector<int> baseline = runBaseline(hamiltonianProblem, n, edges, seed,
+                                          deadline, options, results);
+  runLocalSearch(hamiltonianProblem, timeLimit, deadline, seed, options,
+                 results, baseline);
+  // the weighted local search's conflicts are those of the degree matroids:
+  // the edges sharing the tail or the head
+  if (weights) {
+    runWeighted(hamiltonianProblem, timeLimit, deadline, options, results,
+                std::make_shared<PartitionConflictIndex>(n, edges));
+  }
+  // a path's degree matroids are per vertex and its graphic matroid per
+  // component, so it decomposes over the underlying undirected graph
+  runComponents(
+      n, edges, ComponentVertices::Shared, false,
+      [](const GraphComponent &component) {
+        return std::make_shared<StaticHamiltonianPathProblem>(
+            makeStaticHamiltonianPathProblem(component.vertexCount,
+                                             component.edges));
+      },
+      timeLimit, deadline, options, results);
+
+  writer.end(memoryReport({{"graph", edges->getMemoryBytes()},
+                           {"weights", getWeightsBytes(weights)},
+                           {"problem", hamiltonianProblem->getMemoryBytes()},
+                           {"validator", validator->getMemoryBytes()}}));
+}
+
+// Every algorithm on the instance; timeLimit is that of each local search,
+// and the deadline stops all of them
+void solveInstance(const Instance &instance, unsigned int seed,
+                   std::chrono::milliseconds timeLimit,
+                   const Deadline &deadline, const CommandLineOptions &options,
+                   ResultWriter &writer) {
+  switch (instance.type) {
+  case InstanceType::Bipartite:
+    solveBipartite(instance.vertexCount, instance.edges, instance.weights,
+                   seed, timeLimit, deadline, options, writer);
+    return;
+  case InstanceType::ThreeDMatching:
+    solve3DMatching(instance.vertexCount, instance.edges, instance.weights,
+                    seed, timeLimit, deadline, options, writer);
+    return;
+  case InstanceType::Hamiltonian:
+    solveHamiltonian(instance.vertexCount, instance.edges, instance.weights,
+                     seed, timeLimit, deadline, options, writer);
+    return;
+  }
+  throw std::invalid_argument("Unknown instance type");
+}
+
+// --format=json (default, one document) or --format=ndjson (one record per
+// line)
+ResultWriter::Format getOutputFormat(const CommandLineOptions &options) {
+  std::string format = options.getString("format", "json");
+  if (format == "json") {
+    return ResultWriter::Format::Json;
+  }
+  if (format == "ndjson") {
+    return ResultWriter::Format::Ndjson;
+  }
+  throw std::invalid_argument("Unknown output format: " + format);
+}
+
+// --graph=inline (default), --graph=omit or --graph=reference
+ResultWriter::GraphMode getGraphMode(const CommandLineOptions &options) {
+  std::string mode = options.getString("graph", "inline");
+  if (mode == "inline") {
+    return ResultWriter::GraphMode::Inline;
+  }
+  if (mode == "omit") {
+    return ResultWriter::GraphMode::Omit;
+  }
+  if (mode == "reference") {
+    return ResultWriter::GraphMode::Reference;
+  }
+  throw std::invalid_argument("Unknown graph mode: " + mode);
+}
+
+void printUsage(const std::string &program) {
+  std::cerr << "Usage: " << program << " <command> [args...] [options]"
+            << std::endl;
+  std::cerr << "Commands:" << std::endl;
+  std::cerr << "  bipartite <n> <p> [seed] [timeLimit]" << std::endl;
+  std::cerr << "  3dmatching <n> <p> [seed] [timeLimit]" << std::endl;
+  std::cerr << "  hamiltonian <n> <p> [minHamiltonianPathLength] [seed] "
+               "[timeLimit]"
+            << std::endl;
+  std::cerr << "  save <file> <command> [args...]  write the generated "
+               "instance to a binary file"
+            << std::endl;
+  std::cerr << "  load <file> [seed] [timeLimit]  solve an instance "
+               "written by save"
+            << std::endl;
+  std::cerr << "  batch [jobFile]  run one command line per input line "
+               "(stdin by default), one JSON record per job"
+            << std::endl;
+  std::cerr << "timeLimit: seconds per local search, fractions allowed "
+               "(default 10)"
+            << std::endl;
+  std::cerr << "Options:" << std::endl;
+  std::cerr << "  --threads=<N>  multi-start local search on N threads"
+            << std::endl;
+  std::cerr << "  --search-threads=<N>  explore each local search step "
+               "on N threads"
+            << std::endl;
+  std::cerr << "  --start=<empty|baseline>  start local search from the "
+               "empty set, or from the baseline solution skipping step 0"
+            << std::endl;
+  std::cerr << "  --order=<index|mindegree|random|fewestconflicts>  "
+               "the order of the baseline scan: as generated, by degree, "
+               "shuffled by the seed, or the dynamic fewest-conflicts greedy"
+            << std::endl;
+  std::cerr << "  --search=<exhaustive|sampling|both>  enumerate the "
+               "local search exchanges, sample them at random, or both at "
+               "the same time limit"
+            << std::endl;
+  std::cerr << "  --max-removals=<s>  the most elements a sample removes "
+               "(default 3)"
+            << std::endl;
+  std::cerr << "  --annealing=<p> --cooling=<c>  keep a sample of equal "
+               "size with probability p, times c per sample (default 0, "
+               "0.9999)"
+            << std::endl;
+  std::cerr << "  --restart-interval=<N>  restart the sampling from a "
+               "random greedy solution after N samples without a new best "
+               "(default 100000, 0 for never)"
+            << std::endl;
+  std::cerr << "  --component-threads=<N>  also solve the connected "
+               "components as separate problems on N threads, merged into "
+               "componentbaseline and componentlocalsearch"
+            << std::endl;
+  std::cerr << "  --kernelize  also solve the matchings' kernel under "
+               "safe reduction rules, as kernelbaseline and "
+               "kernellocalsearch"
+            << std::endl;
+  std::cerr << "  --max-weight=<W>  random integer element weights in "
+               "[1, W] from the seed; adds the weighted greedy and the "
+               "weighted local search"
+            << std::endl;
+  std::cerr << "  --sampling=<percandidate|geometric>  random edge "
+               "sampling; geometric takes time proportional to the edges "
+               "kept"
+            << std::endl;
+  std::cerr << "  --generator-threads=<N>  generate the graph from "
+               "counter-based streams on N threads; the graph depends on "
+               "the seed only, not on N"
+            << std::endl;
+  std::cerr << "  --format=<json|ndjson>  one JSON document, or one "
+               "record per line"
+            << std::endl;
+  std::cerr << "  --graph=<inline|omit|reference>  the edges, nothing, or "
+               "the instance file (the loaded one, or --instance-file=<f> "
+               "which is written)"
+            << std::endl;
+  std::cerr << "  --jobs=<N>  batch jobs run on N threads" << std::endl;
+  std::cerr << "  --batch-time-limit=<seconds>  cancel the running batch "
+               "jobs and skip the rest once it has passed"
+            << std::endl;
+}
+
+// Runs one command line, positional arguments and options, writing its
+// output to out; setting cancelled stops its algorithms
+void runCommand(const CommandLineOptions &options, std::ostream &out,
+                const std::atomic<bool> *cancelled = nullptr) {
+  auto args = options.positional;
+  // save <file> <command> [args...] generates the instance of the command
+  // and writes it to file instead of solving it
+  std::string savePath;
+  if (args.size() >= 3 && args[1] == "save") {
+    savePath = args[2];
+    args.erase(args.begin() + 1, args.begin() + 3);
+  }
+  int argCount = static_cast<int>(args.size());
+  if (argCount < 2) {
+    throw std::invalid_argument("Invalid command or arguments");
+  }
+
+  std::string command = args[1];
+  // the file the graph is referenced by: the loaded one, or for generated
+  // instances --instance-file, which the instance is written to
+  std::string instancePath = options.getString("instance-file", "");
+  Instance instance;
+  unsigned int seed = 42;
+  std::chrono::milliseconds timeLimit(10000);
+
+  if (command == "bipartite" && argCount >= 4) {
+    int n = std::stoi(args[2]);
+    double p = std::stod(args[3]);
+    seed = (argCount >= 5) ? std::stoul(args[4]) : 42;
+    if (argCount >= 6) {
+      timeLimit = parseTimeLimit(args[5]);
+    }
+
+    // Generate random bipartite graph
+    GraphGenerator gen(seed, getSamplingMode(options),
+                       options.getInt("generator-threads", 0));
+    auto edges = std::make_shared<const HyperedgeList>(
+        gen.generateErdosRenyiBipartite(n, p));
+    std::cerr << "Generated " << edges->size() << " edges" << std::endl;
+    instance = {InstanceType::Bipartite, n, edges};
+
+  } else if (command == "3dmatching" && argCount >= 4) {
+    int n = std::stoi(args[2]);
+    double p = std::stod(args[3]);
+    seed = (argCount >= 5) ? std::stoul(args[4]) : 42;
+    if (argCount >= 6) {
+      timeLimit = parseTimeLimit(args[5]);
+    }
+
+    // Generate 3D matching instance using tripartite hypergraph
+    GraphGenerator gen(seed, getSamplingMode(options),
+                       options.getInt("generator-threads", 0));
+    auto hyperedges =
+        std::make_shared<const HyperedgeList>(gen.generate3DGraph(n, p));
+    std::cerr << "Generated " << hyperedges->size() << " hyperedges"
+              << std::endl;
+    instance = {InstanceType::ThreeDMatching, n, hyperedges};
+
+  } else if (command == "hamiltonian" && argCount >= 4) {
+    int n = std::stoi(args[2]);
+    double p = std::stod(args[3]);
+
+    // Parse optional minHamiltonianPathLength, seed, and timeLimit
+    // Format: hamiltonian <n> <p> [minHamiltonianPathLength] [seed]
+    // [timeLimit]
+    int minHamiltonianPathLength = 0;
+
+    if (argCount >= 5) {
+      if (argCount >= 6) {
+        if (argCount >= 7) {
+          // All three optional parameters provided
+          minHamiltonianPathLength = std::stoi(args[4]);
+          seed = std::stoul(args[5]);
+          timeLimit = parseTimeLimit(args[6]);
         } else {
-          // Only minHamiltonianPathLength provided (argc == 5)
-          minHamiltonianPathLength = std::stoi(argv[4]);
+          // minHamiltonianPathLength and seed provided
+          minHamiltonianPathLength = std::stoi(args[4]);
+          seed = std::stoul(args[5]);
         }
+      } else {
+        // Only minHamiltonianPathLength provided (argCount == 5)
+        minHamiltonianPathLength = std::stoi(args[4]);
       }
+    }
 
-      // Generate random directed graph for Hamiltonian path
-      GraphGenerator gen(seed);
-      auto edges =
-          gen.generateRandomDirectedGraph(n, p, minHamiltonianPathLength);
-      std::cerr << "Generated " << edges.size() << " edges" << std::endl;
+    // Generate random directed graph for Hamiltonian path
+    GraphGenerator gen(seed, getSamplingMode(options),
+                       options.getInt("generator-threads", 0));
+    auto edges =
+        gen.generateRandomDirectedGraph(n, p, minHamiltonianPathLength);
+    std::cerr << "Generated " << edges.size() << " edges" << std::endl;
+    instance = {InstanceType::Hamiltonian, n,
+                std::make_shared<const HyperedgeList>(
+                    HyperedgeList::fromPairs(edges))};
 
-      // Create HamiltonianPathProblem
-      auto hamiltonianProblem = std::make_shared<HamiltonianPathProblem>(
-          static_cast<int>(edges.size()), n, edges);
+  } else if (command == "load" && argCount >= 3 && savePath.empty()) {
+    seed = (argCount >= 4) ? std::stoul(args[3]) : 42;
+    if (argCount >= 5) {
+      timeLimit = parseTimeLimit(args[4]);
+    }
+    instancePath = args[2];
+    instance = loadInstance(instancePath);
+    std::cerr << "Loaded " << instance.edges->size() << " edges"
+              << std::endl;
 
-      // Run baseline algorithm
-      BaselineAlgorithm baseline(hamiltonianProblem);
-      auto baselineResult = baseline.run();
+  } else {
+    throw std::invalid_argument("Invalid command or arguments");
+  }
+
+  if (!savePath.empty()) {
+    saveInstance(savePath, instance);
+    std::cerr << "Saved to " << savePath << std::endl;
+    return;
+  }
+  // --max-weight=W gives the elements random integer weights in [1, W],
+  // a function of the seed only, so a loaded instance gets them too
+  int maxWeight = options.getInt("max-weight", 0);
+  if (maxWeight > 0) {
+    instance.weights = std::make_shared<const std::vector<double>>(
+        GraphGenerator(seed).generateWeights(instance.edges->size(),
+                                             maxWeight));
+  }
+  auto graphMode = getGraphMode(options);
+  // reject an unknown --start, --order or --search before any output
+  startsFromBaseline(options);
+  getElementOrdering(options);
+  getSearchMode(options);
+  if (graphMode == ResultWriter::GraphMode::Reference &&
+      command != "load" && !instancePath.empty()) {
+    saveInstance(instancePath, instance);
+  }
+  ResultWriter writer(out, getOutputFormat(options), graphMode,
+                      instancePath);
+  try {
+    solveInstance(instance, seed, timeLimit, Deadline(cancelled), options,
+                  writer);
+  } catch (const std::exception &e) {
+    // e.g. a solution failing validation after the graph and the earlier
+    // solutions were written
+    writer.fail(e.what());
+    throw;
+  }
+}
 
-      // Reset problem and run local search
-      hamiltonianProblem->reset();
-      LocalSearchAlgorithm localSearch(hamiltonianProblem, timeLimit);
-      auto localSearchResults = localSearch.run();
+// One job of a batch: a command line without the program name, with the
+// options of the batch itself as defaults. Returns its output, always a single
+// JSON line, {"error": <message>} if the job failed or was cancelled before
+// it started.
+std::string runJob(const std::string &line, const CommandLineOptions &defaults,
+                   const std::atomic<bool> &cancelled) {
+  std::vector<std::string> words = {defaults.positional[0]};
+  std::istringstream wordStream(line);
+  for (std::string word; wordStream >> word;) {
+    words.push_back(word);
+  }
+  CommandLineOptions options(words);
+  options.named.insert(defaults.named.begin(), defaults.named.end());
+  options.named["format"] = "json";
+  std::ostringstream out;
+  try {
+    if (options.positional.size() >= 2 && options.positional[1] == "batch") {
+      throw std::invalid_argument("Batches can't be nested");
+    }
+    if (cancelled) {
+      throw std::runtime_error("Batch time limit reached");
+    }
+    runCommand(options, out, &cancelled);
+  } catch (const std::exception &e) {
+    out.str("");
+    out << nlohmann::json{{"error", e.what()}}.dump() << '\n';
+  }
+  std::string record = out.str();
+  if (record.empty()) {
+    // e.g. save writes nothing
+    record = "{}\n";
+  }
+  return record;
+}
 
-      AlgorithmResults results{baselineResult, localSearchResults};
+// Runs the jobs of in (one command line per line; blank lines and lines
+// starting with # are skipped) on workerCount threads as they are read, and
+// writes one record per job to out, in input order. Once timeLimit (if
+// positive) has passed, a watchdog cancels the running jobs, which stop
+// cooperatively, and the remaining ones are skipped.
+void runBatch(std::istream &in, const CommandLineOptions &defaults,
+              int workerCount, std::chrono::milliseconds timeLimit,
+              std::ostream &out) {
+  std::mutex mutex;
+  std::condition_variable jobReady;
+  std::condition_variable batchDone;
+  bool jobsDone = false;
+  std::atomic<bool> cancelled{false};
+  std::deque<std::pair<long, std::string>> pending; // jobs not yet started
+  bool inputDone = false;
+  std::map<long, std::string> finished; // records waiting for earlier jobs
+  long nextRecord = 0;
 
-      // Validate all solutions before outputting
-      validate_hamiltonian_path(n, edges, baselineResult.getSolution());
-      for (const auto &solution : localSearchResults) {
-        validate_hamiltonian_path(n, edges, solution.getSolution());
+  auto worker = [&]() {
+    while (true) {
+      std::pair<long, std::string> job;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        jobReady.wait(lock, [&]() { return !pending.empty() || inputDone; });
+        if (pending.empty()) {
+          return;
+        }
+        job = std::move(pending.front());
+        pending.pop_front();
       }
+      std::string record = runJob(job.second, defaults, cancelled);
+      std::lock_guard<std::mutex> lock(mutex);
+      finished[job.first] = std::move(record);
+      for (auto it = finished.begin();
+           it != finished.end() && it->first == nextRecord;
+           it = finished.erase(it)) {
+        out << it->second;
+        ++nextRecord;
+      }
+      out.flush();
+    }
+  };
 
-      // Build JSON output using helper functions
-      auto graphJson = graphToJson(edges);
-      auto output = buildOutputJson("HAMILTONIAN", graphJson, results);
-
-      std::cout << output.dump() << std::endl;
+  std::thread watchdog;
+  if (timeLimit.count() > 0) {
+    auto end = std::chrono::steady_clock::now() + timeLimit;
+    watchdog = std::thread([&, end]() {
+      std::unique_lock<std::mutex> lock(mutex);
+      if (!batchDone.wait_until(lock, end, [&]() { return jobsDone; })) {
+        cancelled = true;
+      }
+    });
+  }
+  std::vector<std::thread> workers;
+  for (int t = 0; t < workerCount; t++) {
+    workers.emplace_back(worker);
+  }
+  long jobCount = 0;
+  for (std::string line; std::getline(in, line);) {
+    auto first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#') {
+      continue;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      pending.emplace_back(jobCount++, std::move(line));
+    }
+    jobReady.notify_one();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    inputDone = true;
+  }
+  jobReady.notify_all();
+  for (auto &thread : workers) {
+    thread.join();
+  }
+  if (watchdog.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      jobsDone = true;
+    }
+    batchDone.notify_all();
+    watchdog.join();
+  }
+}
 
-    } else {
-      std::cerr << "Invalid command or arguments" << std::endl;
+// Parse command line arguments and run experiments
+int main(int argc, char *argv[]) {
+  try {
+    CommandLineOptions options(argc, argv);
+    const auto &args = options.positional;
+    if (args.size() < 2) {
+      printUsage(args[0]);
       return 1;
     }
-
+    if (args[1] == "batch") {
+      int workerCount = options.getInt("jobs", 1);
+      if (workerCount < 1) {
+        throw std::invalid_argument("--jobs must be at least 1");
+      }
+      auto timeLimit =
+          parseTimeLimit(options.getString("batch-time-limit", "0"));
+      CommandLineOptions defaults = options;
+      defaults.named.erase("jobs");
+      defaults.named.erase("batch-time-limit");
+      if (args.size() >= 3) {
+        std::ifstream jobs(args[2]);
+        if (!jobs) {
+          throw std::runtime_error("Cannot open " + args[2]);
+        }
+        runBatch(jobs, defaults, workerCount, timeLimit, std::cout);
+      } else {
+        runBatch(std::cin, defaults, workerCount, timeLimit, std::cout);
+      }
+      return 0;
+    }
+    runCommand(options, std::cout);
     return 0;
   } catch (const std::exception &e) {
     std::cerr << "Error: " << e.what() << std::endl;
@@ -0,0 +1,428 @@
+#include "command_line_options.h"
+#include "conflict_index.h"
+#include "element_order.h"
+#include "graph_generator.h"
+#include "matroid_intersection.h"
+#include "matroid_problem.h"
+#include "oracle_counters.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// Sweeps the problem types over the graph sizes n, edge probabilities p and
+// local search steps s, timing every algorithm after warmup runs and
+// reporting one row per configuration as CSV or JSON.
+
+namespace {
+
+// What one run of an algorithm reports besides its time; a counter the
+// algorithm doesn't keep is -1. oracleCalls are the canAdd and canExchange
+// queries of every matroid, measured by the problem's OracleCounters, so
+// only in a build with MATROID_ORACLE_COUNTERS
+struct RunResult {
+  int solutionSize = 0;
+  std::int64_t oracleCalls = -1;
+  std::int64_t exchangeAttempts = -1;
+  std::int64_t improvements = -1;
+};
+
+struct BenchmarkRow {
+  std::string problem;
+  int k = 0;
+  int n = 0;
+  double p = 0;
+  int s = -1; // local search only
+  std::string algorithm;
+  int edges = 0;
+  int repetitions = 0;
+  double meanSeconds = 0;
+  double minSeconds = 0;
+  RunResult result; // of the last repetition
+  long peakRssKb = -1;
+};
+
+// Peak resident set size of the process so far, in KiB; -1 where unknown.
+// A high-water mark, so a row only shows growth over the earlier rows.
+long peakRssKb() {
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // bytes there
+#else
+    return usage.ru_maxrss;
+#endif
+  }
+#endif
+  return -1;
+}
+
+// The matroid queries counted since the problem's last
+// resetOracleCounters, or -1 if the build doesn't count them
+std::int64_t countOracleCalls(const OracleCounters &counters) {
+  if constexpr (!kOracleCountersEnabled) {
+    return -1;
+  }
+  std::int64_t calls = 0;
+  for (const auto &matroid : counters.matroids) {
+    calls += matroid.canAddCalls + matroid.canExchangeCalls;
+  }
+  return calls;
+}
+
+// Local search queries its insertion candidates in batches only, so in a
+// build that counts them no matroid can have answered more canAdd calls
+// than the search checked candidates; more means the counts are wrong
+void checkCandidateCalls(const OracleCounters &counters,
+                         std::int64_t candidateChecks) {
+  if constexpr (kOracleCountersEnabled) {
+    for (const auto &matroid : counters.matroids) {
+      if (matroid.canAddCalls > candidateChecks) {
+        throw std::logic_error(
+            "A matroid answered " + std::to_string(matroid.canAddCalls) +
+            " canAdd calls for " + std::to_string(candidateChecks) +
+            " candidate checks");
+      }
+    }
+  }
+}
+
+struct BenchmarkOptions {
+  int warmup;
+  int repetitions;
+  std::vector<ElementOrdering> orders; // of the baseline, one row each
+  unsigned int seed;                   // also of the random order
+};
+
+// Runs the algorithm warmup + repetitions times, timing the repetitions
+BenchmarkRow measure(const BenchmarkOptions &options,
+                     const std::function<RunResult()> &run) {
+  for (int i = 0; i < options.warmup; i++) {
+    run();
+  }
+  BenchmarkRow row;
+  row.repetitions = options.repetitions;
+  double total = 0;
+  for (int i = 0; i < options.repetitions; i++) {
+    auto start = std::chrono::steady_clock::now();
+    row.result = run();
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    total += seconds;
+    row.minSeconds = i == 0 ? seconds : std::min(row.minSeconds, seconds);
+  }
+  row.meanSeconds = total / options.repetitions;
+  row.peakRssKb = peakRssKb();
+  return row;
+}
+
+// The baseline in every order and local search for every s on a reset
+// problem, appended to rows; the problem is built once, outside the timing,
+// but the time of a baseline includes computing its order from columns, the
+// edges as partition columns of vertexCount vertices
+template <typename Problem>
+void benchmarkLocalSearch(
+    const std::shared_ptr<Problem> &problem, int vertexCount,
+    const std::shared_ptr<const HyperedgeList> &columns,
+    const std::vector<int> &steps, std::chrono::milliseconds timeLimit,
+    const BenchmarkOptions &options,
+    const std::shared_ptr<const PartitionConflictIndex> &conflictIndex,
+    const BenchmarkRow &configuration, std::vector<BenchmarkRow> &rows) {
+  auto add = [&](BenchmarkRow row, const std::string &algorithm, int s) {
+    row.problem = configuration.problem;
+    row.k = configuration.k;
+    row.n = configuration.n;
+    row.p = configuration.p;
+    row.edges = configuration.edges;
+    row.algorithm = algorithm;
+    row.s = s;
+    rows.push_back(std::move(row));
+  };
+
+  for (ElementOrdering ordering : options.orders) {
+    add(measure(options,
+                [&] {
+                  BasicBaselineAlgorithm baseline(problem);
+                  if (ordering != ElementOrdering::Index) {
+                    baseline.setElementOrder(computeElementOrder(
+                        ordering, vertexCount, columns, options.seed));
+                  }
+                  problem->resetOracleCounters();
+                  RunResult result;
+                  result.solutionSize =
+                      static_cast<int>(baseline.run().getSolution().size());
+                  result.oracleCalls =
+                      countOracleCalls(problem->getOracleCounters());
+                  problem->reset();
+                  return result;
+                }),
+        ordering == ElementOrdering::Index
+            ? std::string("baseline")
+            : std::string("baseline-") + getElementOrderingName(ordering),
+        -1);
+  }
+
+  for (int s : steps) {
+    add(measure(options,
+                [&] {
+                  BasicLocalSearchAlgorithm localSearch(problem, timeLimit);
+                  localSearch.setVerbose(false);
+                  localSearch.setMaxStep(s);
+                  localSearch.setConflictIndex(conflictIndex);
+                  problem->resetOracleCounters();
+                  auto solutions = localSearch.run();
+                  RunResult result;
+                  // none if the time limit expires before step 0 completes
+                  if (!solutions.empty()) {
+                    result.solutionSize = static_cast<int>(
+                        solutions.back().getSolution().size());
+                  }
+                  result.oracleCalls =
+                      countOracleCalls(problem->getOracleCounters());
+                  checkCandidateCalls(problem->getOracleCounters(),
+                                      localSearch.getCandidateCheckCount());
+                  result.exchangeAttempts =
+                      localSearch.getExchangeAttemptCount();
+                  result.improvements = localSearch.getImprovementCount();
+                  problem->reset();
+                  return result;
+                }),
+        "localsearch", s);
+  }
+}
+
+// The exact bipartite algorithms, which don't count oracle calls
+void benchmarkExactBipartite(const std::shared_ptr<MatchingProblem> &problem,
+                             const BenchmarkOptions &options,
+                             const BenchmarkRow &configuration,
+                             std::vector<BenchmarkRow> &rows) {
+  auto add = [&](const std::string &algorithm,
+                 const std::function<ApproximationSolution()> &run) {
+    BenchmarkRow row = measure(options, [&] {
+      RunResult result;
+      result.solutionSize = static_cast<int>(run().getSolution().size());
+      problem->reset();
+      return result;
+    });
+    row.problem = configuration.problem;
+    row.k = configuration.k;
+    row.n = configuration.n;
+    row.p = configuration.p;
+    row.edges = configuration.edges;
+    row.algorithm = algorithm;
+    rows.push_back(std::move(row));
+  };
+  add("kuhn", [&] { return Kuhn2dMatchingAlgorithm(problem).run(); });
+  add("hopcroftkarp",
+      [&] { return HopcroftKarpMatchingAlgorithm(problem).run(); });
+  add("exchange",
+      [&] { return ExchangeGraphIntersectionAlgorithm(problem).run(); });
+}
+
+// One (problem, n, p) configuration: generates the instance with the given
+// seed and appends a row per algorithm (and per s for local search)
+void benchmarkConfiguration(const std::string &problem, int n, double p,
+                            const std::vector<int> &steps, unsigned int seed,
+                            std::chrono::milliseconds timeLimit,
+                            const BenchmarkOptions &options,
+                            std::vector<BenchmarkRow> &rows) {
+  GraphGenerator gen(seed);
+  BenchmarkRow configuration;
+  configuration.problem = problem;
+  configuration.n = n;
+  configuration.p = p;
+
+  if (problem == "bipartite") {
+    auto edges = std::make_shared<const HyperedgeList>(
+        gen.generateErdosRenyiBipartite(n, p));
+    configuration.k = 2;
+    configuration.edges = edges->size();
+    auto conflictIndex = std::make_shared<PartitionConflictIndex>(n, edges);
+    benchmarkLocalSearch(std::make_shared<StaticBipartiteMatchingProblem>(
+                             makeStaticBipartiteMatchingProblem(n, edges)),
+                         n, edges, steps, timeLimit, options, conflictIndex,
+                         configuration, rows);
+    benchmarkExactBipartite(std::make_shared<MatchingProblem>(n, edges),
+                            options, configuration, rows);
+  } else if (problem == "3dmatching") {
+    auto hyperedges =
+        std::make_shared<const HyperedgeList>(gen.generate3DGraph(n, p));
+    configuration.k = 3;
+    configuration.edges = hyperedges->size();
+    auto conflictIndex =
+        std::make_shared<PartitionConflictIndex>(n, hyperedges);
+    benchmarkLocalSearch(std::make_shared<Static3DMatchingProblem>(
+                             makeStatic3DMatchingProblem(n, hyperedges)),
+                         n, hyperedges, steps, timeLimit, options,
+                         conflictIndex, configuration, rows);
+  } else if (problem == "hamiltonian") {
+    // with a planted Hamiltonian path, so the optimum is n - 1
+    auto edges = gen.generateRandomDirectedGraph(n, p, n - 1);
+    configuration.k = 3;
+    configuration.edges = static_cast<int>(edges.size());
+    std::vector<std::vector<int>> columns(2);
+    for (const auto &[from, to] : edges) {
+      columns[0].push_back(from);
+      columns[1].push_back(to);
+    }
+    benchmarkLocalSearch(std::make_shared<StaticHamiltonianPathProblem>(
+                             makeStaticHamiltonianPathProblem(n, edges)),
+                         n,
+                         std::make_shared<const HyperedgeList>(
+                             std::move(columns)),
+                         steps, timeLimit, options, nullptr, configuration,
+                         rows);
+  } else {
+    throw std::invalid_argument("Unknown problem: " + problem);
+  }
+}
+
+// A counter, or nothing for one the algorithm doesn't keep
+std::string counterToCsv(std::int64_t value) {
+  return value < 0 ? "" : std::to_string(value);
+}
+
+nlohmann::json counterToJson(std::int64_t value) {
+  return value < 0 ? nlohmann::json(nullptr) : nlohmann::json(value);
+}
+
+// Oracle calls per second of the mean run
+double oracleCallRate(const BenchmarkRow &row) {
+  return row.meanSeconds > 0 ? row.result.oracleCalls / row.meanSeconds : 0;
+}
+
+void writeCsv(std::ostream &out, const std::vector<BenchmarkRow> &rows) {
+  out << "problem,k,n,p,s,algorithm,edges,repetitions,meanSeconds,"
+         "minSeconds,solutionSize,oracleCalls,oracleCallsPerSecond,"
+         "exchangeAttempts,improvements,peakRssKb\n";
+  for (const auto &row : rows) {
+    out << row.problem << ',' << row.k << ',' << row.n << ',' << row.p << ','
+        << counterToCsv(row.s) << ',' << row.algorithm << ',' << row.edges
+        << ',' << row.repetitions << ',' << row.meanSeconds << ','
+        << row.minSeconds << ',' << row.result.solutionSize << ','
+        << counterToCsv(row.result.oracleCalls) << ',';
+    if (row.result.oracleCalls >= 0) {
+      out << oracleCallRate(row);
+    }
+    out << ',' << counterToCsv(row.result.exchangeAttempts) << ','
+        << counterToCsv(row.result.improvements) << ','
+        << counterToCsv(row.peakRssKb) << '\n';
+  }
+}
+
+void writeJson(std::ostream &out, const std::vector<BenchmarkRow> &rows) {
+  nlohmann::json json = nlohmann::json::array();
+  for (const auto &row : rows) {
+    json.push_back(
+        {{"problem", row.problem},
+         {"k", row.k},
+         {"n", row.n},
+         {"p", row.p},
+         {"s", counterToJson(row.s)},
+         {"algorithm", row.algorithm},
+         {"edges", row.edges},
+         {"repetitions", row.repetitions},
+         {"meanSeconds", row.meanSeconds},
+         {"minSeconds", row.minSeconds},
+         {"solutionSize", row.result.solutionSize},
+         {"oracleCalls", counterToJson(row.result.oracleCalls)},
+         {"oracleCallsPerSecond", row.result.oracleCalls < 0
+                                      ? nlohmann::json(nullptr)
+                                      : nlohmann::json(oracleCallRate(row))},
+         {"exchangeAttempts", counterToJson(row.result.exchangeAttempts)},
+         {"improvements", counterToJson(row.result.improvements)},
+         {"peakRssKb", counterToJson(row.peakRssKb)}});
+  }
+  out << json.dump(2) << std::endl;
+}
+
+void printUsage(const std::string &program) {
+  std::cerr
+      << "Usage: " << program << " [options]\n"
+      << "  --problems=bipartite,3dmatching,hamiltonian  problems to run\n"
+      << "  --n=100,200      vertices per partition (of the graph for "
+         "hamiltonian)\n"
+      << "  --p=0.05         edge probabilities\n"
+      << "  --s=1,2          last local search steps (remove s, add s + 1)\n"
+      << "  --orders=index   baseline element orders: index, mindegree, "
+         "random,\n"
+      << "                   fewestconflicts; one baseline-<order> row "
+         "each\n"
+      << "  --warmup=1       untimed runs before the timed ones\n"
+      << "  --repetitions=3  timed runs per row\n"
+      << "  --seed=42        seed of the generated instances\n"
+      << "  --time-limit=60  cap of a local search run, in seconds "
+         "(fractions allowed)\n"
+      << "  --format=csv     csv or json" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  CommandLineOptions options(argc, argv);
+  if (options.positional.size() > 1 || options.named.count("help")) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  try {
+    unsigned int seed =
+        static_cast<unsigned int>(std::stoul(options.getString("seed", "42")));
+    BenchmarkOptions benchmarkOptions{options.getInt("warmup", 1),
+                                      options.getInt("repetitions", 3),
+                                      {},
+                                      seed};
+    if (benchmarkOptions.warmup < 0 || benchmarkOptions.repetitions < 1) {
+      throw std::invalid_argument("Needs warmup >= 0 and repetitions >= 1");
+    }
+    for (const auto &order : options.getList("orders", "index")) {
+      benchmarkOptions.orders.push_back(parseElementOrdering(order));
+    }
+    std::string format = options.getString("format", "csv");
+    if (format != "csv" && format != "json") {
+      throw std::invalid_argument("Unknown output format: " + format);
+    }
+    std::chrono::milliseconds timeLimit =
+        parseTimeLimit(options.getString("time-limit", "60"));
+    std::vector<int> steps;
+    for (const auto &s : options.getList("s", "1,2")) {
+      steps.push_back(std::stoi(s));
+    }
+
+    std::vector<BenchmarkRow> rows;
+    for (const auto &problem :
+         options.getList("problems", "bipartite,3dmatching,hamiltonian")) {
+      for (const auto &n : options.getList("n", "100,200")) {
+        for (const auto &p : options.getList("p", "0.05")) {
+          std::cerr << "Running " << problem << " n=" << n << " p=" << p
+                    << std::endl;
+          benchmarkConfiguration(problem, std::stoi(n), std::stod(p), steps,
+                                 seed, timeLimit, benchmarkOptions, rows);
+        }
+      }
+    }
+
+    if (format == "csv") {
+      writeCsv(std::cout, rows);
+    } else {
+      writeJson(std::cout, rows);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
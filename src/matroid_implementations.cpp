@@ -2,47 +2,66 @@
 #include <algorithm>
 #include <cassert>
 #include <queue>
+#include <stdexcept>
 #include <unordered_set>
 
-// MatchingProblem implementation
-MatchingProblem::MatchingProblem(int graphRank, int vertexPerPartitionCount,
-                                 const std::vector<std::vector<int>> &edge_list)
-    : MatroidProblem(static_cast<int>(edge_list.size()), graphRank),
-      edges_(edge_list), vertexPerPartitionCount_(vertexPerPartitionCount) {
-
-  // ensure all edges have the same rank
-  for (const auto &edge : edge_list) {
-    if (static_cast<int>(edge.size()) != graphRank) {
-      throw std::invalid_argument("All edges must have the same rank");
-    }
-  }
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
+// MatchingProblem implementation
+MatchingProblem::MatchingProblem(int vertexPerPartitionCount,
+                                 std::shared_ptr<const HyperedgeList> edges)
+    : MatroidProblem(edges->size(), edges->getRank()), edges_(std::move(edges)),
+      vertexPerPartitionCount_(vertexPerPartitionCount) {
   // For each partition, create a partition matroid set
   // The partition matroid ensures at most one edge containing each vertex is
   // selected
-  std::vector<std::vector<int>> edge_to_vertices(matroidQuantity_);
-  for (int edge_i = 0; edge_i < groundSetSize_; ++edge_i) {
-    for (int p = 0; p < matroidQuantity_; ++p) {
-      edge_to_vertices[p].push_back(edges_[edge_i][p]);
-    }
-  }
-
   for (int p = 0; p < matroidQuantity_; ++p) {
     matroids_.push_back(std::make_unique<PartitionMatroidSet>(
-        groundSetSize_, vertexPerPartitionCount_, edge_to_vertices[p]));
+        vertexPerPartitionCount_, edges_, p));
+  }
+}
+
+MatchingProblem::MatchingProblem(int graphRank, int vertexPerPartitionCount,
+                                 const std::vector<std::vector<int>> &edge_list)
+    : MatchingProblem(vertexPerPartitionCount,
+                      std::make_shared<const HyperedgeList>(
+                          HyperedgeList::fromRows(graphRank, edge_list))) {}
+
+StaticBipartiteMatchingProblem makeStaticBipartiteMatchingProblem(
+    int vertexPerPartitionCount,
+    const std::shared_ptr<const HyperedgeList> &edges) {
+  using Set = MatchingProblem::PartitionMatroidSet;
+  if (edges->getRank() != 2) {
+    throw std::invalid_argument("All edges must have the same rank");
+  }
+  return StaticBipartiteMatchingProblem(
+      edges->size(), Set(vertexPerPartitionCount, edges, 0),
+      Set(vertexPerPartitionCount, edges, 1));
+}
+
+Static3DMatchingProblem
+makeStatic3DMatchingProblem(int vertexPerPartitionCount,
+                            const std::shared_ptr<const HyperedgeList> &edges) {
+  using Set = MatchingProblem::PartitionMatroidSet;
+  if (edges->getRank() != 3) {
+    throw std::invalid_argument("All edges must have the same rank");
   }
+  return Static3DMatchingProblem(edges->size(),
+                                 Set(vertexPerPartitionCount, edges, 0),
+                                 Set(vertexPerPartitionCount, edges, 1),
+                                 Set(vertexPerPartitionCount, edges, 2));
 }
 
 // PartitionMatroidSet implementation
 MatchingProblem::PartitionMatroidSet::PartitionMatroidSet(
-    int groundSetSize, int vertexPerPartitionCount,
-    const std::vector<int> &edge_to_vertex)
-    : groundSetSize_(groundSetSize),
+    int vertexPerPartitionCount, std::shared_ptr<const HyperedgeList> edges,
+    int partition)
+    : groundSetSize_(edges->size()),
       vertexPerPartitionCount_(vertexPerPartitionCount),
-      edge_to_vertex_(edge_to_vertex) {
-  is_vertex_used_ = std::vector<bool>(vertexPerPartitionCount_, false);
-  is_edge_used_ = std::vector<bool>(groundSetSize_, false);
-}
+      edges_(std::move(edges)), edge_to_vertex_(edges_->getColumn(partition)),
+      vertex_owner_(vertexPerPartitionCount_, -1) {}
 
 bool MatchingProblem::PartitionMatroidSet::tryAddElement(int element) {
   assert(element >= 0 && element < groundSetSize_);
@@ -51,58 +70,142 @@ bool MatchingProblem::PartitionMatroidSet::tryAddElement(int element) {
     throw std::invalid_argument("Vertex index out of bounds");
   }
 
-  if (is_edge_used_[element]) {
+  if (vertex_owner_[vertex] == element) {
     throw std::invalid_argument("Edge already used");
   }
 
-  if (is_vertex_used_[vertex]) {
+  if (vertex_owner_[vertex] >= 0) {
     return false;
   }
-  is_vertex_used_[vertex] = true;
-  is_edge_used_[element] = true;
+  vertex_owner_[vertex] = element;
   return true;
 }
 
+bool MatchingProblem::PartitionMatroidSet::canAdd(int element) const {
+  assert(element >= 0 && element < groundSetSize_);
+  return vertex_owner_[edge_to_vertex_[element]] < 0;
+}
+
+bool MatchingProblem::PartitionMatroidSet::canExchange(int removed,
+                                                       int added) const {
+  assert(removed >= 0 && removed < groundSetSize_);
+  assert(added >= 0 && added < groundSetSize_);
+  int vertex = edge_to_vertex_[added];
+  return vertex == edge_to_vertex_[removed] || vertex_owner_[vertex] < 0;
+}
+
+std::uint32_t MatchingProblem::PartitionMatroidSet::canAddBatch(
+    const int *elements, int count, std::uint32_t mask) const {
+  // every element is tested, selected or not: that keeps the loop branchless
+  std::uint32_t free = 0;
+  int i = 0;
+#ifdef __AVX2__
+  for (; i + 8 <= count; i += 8) {
+    __m256i edge =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(elements + i));
+    __m256i vertex = _mm256_i32gather_epi32(edge_to_vertex_, edge, 4);
+    __m256i owner = _mm256_i32gather_epi32(vertex_owner_.data(), vertex, 4);
+    // a free vertex has owner -1: the sign bits are the answer
+    free |= static_cast<std::uint32_t>(
+                _mm256_movemask_ps(_mm256_castsi256_ps(owner)))
+            << i;
+  }
+#endif
+  for (; i < count; i++) {
+    free |= static_cast<std::uint32_t>(
+                vertex_owner_[edge_to_vertex_[elements[i]]] < 0)
+            << i;
+  }
+  return mask & free;
+}
+
 void MatchingProblem::PartitionMatroidSet::removeElement(int element) {
   assert(element >= 0 && element < groundSetSize_);
   int vertex = edge_to_vertex_[element];
   if (vertex < 0 || vertex >= vertexPerPartitionCount_) {
     throw std::invalid_argument("Vertex index out of bounds");
   }
-  if (!is_edge_used_[element]) {
+  if (vertex_owner_[vertex] != element) {
     throw std::invalid_argument("Edge not used");
   }
 
-  is_vertex_used_[vertex] = false;
-  is_edge_used_[element] = false;
+  vertex_owner_[vertex] = -1;
+}
+
+void MatchingProblem::PartitionMatroidSet::restoreElement(int element) {
+  assert(element >= 0 && element < groundSetSize_);
+  vertex_owner_[edge_to_vertex_[element]] = element;
 }
 
 // HamiltonianPathProblem implementation
 HamiltonianPathProblem::HamiltonianPathProblem(
-    int groundSetSize, int vertexCount,
-    const std::vector<std::pair<int, int>> &edges)
-    : MatroidProblem(groundSetSize, 3), edges_(edges) {
+    int vertexCount, std::shared_ptr<const HyperedgeList> edges,
+    GraphicMatroidBackend backend)
+    : MatroidProblem(edges->size(), 3), edges_(std::move(edges)) {
+  if (edges_->getRank() != 2) {
+    throw std::invalid_argument("Expected (from, to) edge columns");
+  }
   matroids_.push_back(
       std::make_unique<HamiltonianPathProblem::SingleIncomingEdgeMatroidSet>(
-          groundSetSize, vertexCount, edges, true));
+          vertexCount, edges_, true));
   matroids_.push_back(
       std::make_unique<HamiltonianPathProblem::SingleIncomingEdgeMatroidSet>(
-          groundSetSize, vertexCount, edges, false));
-  matroids_.push_back(
-      std::make_unique<HamiltonianPathProblem::GraphicMatroidSet>(
-          groundSetSize, vertexCount, edges));
+          vertexCount, edges_, false));
+  // the graphic matroid goes last: PathForestGraphicMatroidSet relies on the
+  // degree matroids having accepted the element already
+  if (backend == GraphicMatroidBackend::NextChain) {
+    matroids_.push_back(
+        std::make_unique<HamiltonianPathProblem::GraphicMatroidSet>(
+            vertexCount, edges_));
+  } else {
+    matroids_.push_back(
+        std::make_unique<HamiltonianPathProblem::PathForestGraphicMatroidSet>(
+            vertexCount, edges_));
+  }
+}
+
+HamiltonianPathProblem::HamiltonianPathProblem(
+    int groundSetSize, int vertexCount,
+    const std::vector<std::pair<int, int>> &edges,
+    GraphicMatroidBackend backend)
+    : HamiltonianPathProblem(vertexCount,
+                             std::make_shared<const HyperedgeList>(
+                                 HyperedgeList::fromPairs(edges)),
+                             backend) {
+  if (groundSetSize != getGroundSetSize()) {
+    throw std::invalid_argument("Expected one edge per ground set element");
+  }
+}
+
+StaticHamiltonianPathProblem makeStaticHamiltonianPathProblem(
+    int vertexCount, const std::shared_ptr<const HyperedgeList> &edges) {
+  if (edges->getRank() != 2) {
+    throw std::invalid_argument("Expected (from, to) edge columns");
+  }
+  return StaticHamiltonianPathProblem(
+      edges->size(),
+      HamiltonianPathProblem::SingleIncomingEdgeMatroidSet(vertexCount, edges,
+                                                           true),
+      HamiltonianPathProblem::SingleIncomingEdgeMatroidSet(vertexCount, edges,
+                                                           false),
+      HamiltonianPathProblem::PathForestGraphicMatroidSet(vertexCount, edges));
+}
+
+StaticHamiltonianPathProblem makeStaticHamiltonianPathProblem(
+    int vertexCount, const std::vector<std::pair<int, int>> &edges) {
+  return makeStaticHamiltonianPathProblem(
+      vertexCount,
+      std::make_shared<const HyperedgeList>(HyperedgeList::fromPairs(edges)));
 }
 
 HamiltonianPathProblem::SingleIncomingEdgeMatroidSet::
-    SingleIncomingEdgeMatroidSet(int groundSetSize, int vertexCount,
-                                 const std::vector<std::pair<int, int>> &edges,
+    SingleIncomingEdgeMatroidSet(int vertexCount,
+                                 std::shared_ptr<const HyperedgeList> edges,
                                  bool is_incoming)
-    : vertexCount_(vertexCount), groundSetSize_(groundSetSize) {
-  edge_to_ = std::vector<int>(groundSetSize_);
+    : vertexCount_(vertexCount), groundSetSize_(edges->size()),
+      edges_(std::move(edges)),
+      edge_to_(edges_->getColumn(is_incoming ? 1 : 0)) {
   is_vertex_used_ = std::vector<bool>(vertexCount_, false);
-  for (int i = 0; i < groundSetSize_; i++) {
-    edge_to_[i] = is_incoming ? edges[i].second : edges[i].first;
-  }
 }
 
 bool HamiltonianPathProblem::SingleIncomingEdgeMatroidSet::tryAddElement(
@@ -115,6 +218,20 @@ bool HamiltonianPathProblem::SingleIncomingEdgeMatroidSet::tryAddElement(
   return true;
 }
 
+bool HamiltonianPathProblem::SingleIncomingEdgeMatroidSet::canAdd(
+    int element) const {
+  assert(element >= 0 && element < groundSetSize_);
+  return !is_vertex_used_[edge_to_[element]];
+}
+
+bool HamiltonianPathProblem::SingleIncomingEdgeMatroidSet::canExchange(
+    int removed, int added) const {
+  assert(removed >= 0 && removed < groundSetSize_);
+  assert(added >= 0 && added < groundSetSize_);
+  int vertex = edge_to_[added];
+  return vertex == edge_to_[removed] || !is_vertex_used_[vertex];
+}
+
 void HamiltonianPathProblem::SingleIncomingEdgeMatroidSet::removeElement(
     int element) {
   assert(element >= 0 && element < groundSetSize_);
@@ -125,17 +242,23 @@ void HamiltonianPathProblem::SingleIncomingEdgeMatroidSet::removeElement(
   is_vertex_used_[edge_to_[element]] = false;
 }
 
+void HamiltonianPathProblem::SingleIncomingEdgeMatroidSet::restoreElement(
+    int element) {
+  assert(element >= 0 && element < groundSetSize_);
+  is_vertex_used_[edge_to_[element]] = true;
+}
+
 HamiltonianPathProblem::GraphicMatroidSet::GraphicMatroidSet(
-    int groundSetSize, int vertexCount,
-    const std::vector<std::pair<int, int>> &edges)
-    : vertexCount_(vertexCount), groundSetSize_(groundSetSize) {
+    int vertexCount, std::shared_ptr<const HyperedgeList> edges)
+    : vertexCount_(vertexCount), groundSetSize_(edges->size()),
+      edges_(std::move(edges)), from_(edges_->getColumn(0)),
+      to_(edges_->getColumn(1)) {
   next_ = std::vector<int>(vertexCount_, -1);
-  edges_ = edges;
 }
 
 bool HamiltonianPathProblem::GraphicMatroidSet::tryAddElement(int element) {
   assert(element >= 0 && element < groundSetSize_);
-  int vertex = edges_[element].second;
+  int vertex = to_[element];
   int count = 0;
   while (next_[vertex] != -1) {
     vertex = next_[vertex];
@@ -144,18 +267,194 @@ bool HamiltonianPathProblem::GraphicMatroidSet::tryAddElement(int element) {
       throw std::runtime_error("Cycle detected");
     }
   }
-  if (vertex == edges_[element].first) {
+  if (vertex == from_[element]) {
     // the edge would form a cycle
     return false;
   }
-  next_[edges_[element].first] = edges_[element].second;
+  next_[from_[element]] = to_[element];
   return true;
 }
 
+bool HamiltonianPathProblem::GraphicMatroidSet::canAdd(int element) const {
+  return canExchange(-1, element);
+}
+
+bool HamiltonianPathProblem::GraphicMatroidSet::canExchange(int removed,
+                                                            int added) const {
+  assert(added >= 0 && added < groundSetSize_);
+  // the chain is cut after the tail of the removed edge, if any
+  int cut = removed == -1 ? -1 : from_[removed];
+  int vertex = to_[added];
+  int count = 0;
+  while (vertex != cut && next_[vertex] != -1) {
+    vertex = next_[vertex];
+    ++count;
+    if (count > vertexCount_) {
+      throw std::runtime_error("Cycle detected");
+    }
+  }
+  return vertex != from_[added];
+}
+
 void HamiltonianPathProblem::GraphicMatroidSet::removeElement(int element) {
   assert(element >= 0 && element < groundSetSize_);
-  if (next_[edges_[element].first] != edges_[element].second) {
+  if (next_[from_[element]] != to_[element]) {
+    throw std::invalid_argument("Edge not found");
+  }
+  next_[from_[element]] = -1;
+}
+
+void HamiltonianPathProblem::GraphicMatroidSet::restoreElement(int element) {
+  assert(element >= 0 && element < groundSetSize_);
+  next_[from_[element]] = to_[element];
+}
+
+HamiltonianPathProblem::PathForestGraphicMatroidSet::
+    PathForestGraphicMatroidSet(int vertexCount,
+                                std::shared_ptr<const HyperedgeList> edges)
+    : vertexCount_(vertexCount), groundSetSize_(edges->size()),
+      edges_(std::move(edges)), from_(edges_->getColumn(0)),
+      to_(edges_->getColumn(1)) {
+  next_ = std::vector<int>(vertexCount_, -1);
+  parent_ = std::vector<int>(vertexCount_, -1);
+  left_ = std::vector<int>(vertexCount_, -1);
+  right_ = std::vector<int>(vertexCount_, -1);
+}
+
+void HamiltonianPathProblem::PathForestGraphicMatroidSet::rotate(
+    int x) const {
+  int p = parent_[x];
+  int g = parent_[p];
+  if (left_[p] == x) {
+    left_[p] = right_[x];
+    if (right_[x] != -1)
+      parent_[right_[x]] = p;
+    right_[x] = p;
+  } else {
+    right_[p] = left_[x];
+    if (left_[x] != -1)
+      parent_[left_[x]] = p;
+    left_[x] = p;
+  }
+  parent_[p] = x;
+  parent_[x] = g;
+  if (g != -1) {
+    if (left_[g] == p)
+      left_[g] = x;
+    else
+      right_[g] = x;
+  }
+}
+
+void HamiltonianPathProblem::PathForestGraphicMatroidSet::splay(
+    int x) const {
+  while (parent_[x] != -1) {
+    int p = parent_[x];
+    int g = parent_[p];
+    if (g != -1) {
+      // zig-zig rotates the parent first, zig-zag rotates x twice
+      bool zigZig = (left_[g] == p) == (left_[p] == x);
+      rotate(zigZig ? p : x);
+    }
+    rotate(x);
+  }
+}
+
+bool HamiltonianPathProblem::PathForestGraphicMatroidSet::isSamePath(
+    int u, int v) const {
+  if (u == v)
+    return true;
+  // after splaying v, u stays the root only if v lives in another tree
+  splay(u);
+  splay(v);
+  return parent_[u] != -1;
+}
+
+bool HamiltonianPathProblem::PathForestGraphicMatroidSet::isUpTo(
+    int v, int x) const {
+  if (v == x)
+    return true;
+  // with x at the root, v lies in its left or its right subtree
+  splay(x);
+  int child = v;
+  while (parent_[child] != x) {
+    child = parent_[child];
+  }
+  bool isBefore = left_[x] == child;
+  splay(v); // pays for the climb
+  return isBefore;
+}
+
+bool HamiltonianPathProblem::PathForestGraphicMatroidSet::canAdd(
+    int element) const {
+  assert(element >= 0 && element < groundSetSize_);
+  return !isSamePath(from_[element], to_[element]);
+}
+
+bool HamiltonianPathProblem::PathForestGraphicMatroidSet::canExchange(
+    int removed, int added) const {
+  assert(removed >= 0 && removed < groundSetSize_);
+  assert(added >= 0 && added < groundSetSize_);
+  int cut = from_[removed];
+  int from = from_[added];
+  int to = to_[added];
+  if (!isSamePath(from, to)) {
+    return true;
+  }
+  if (!isSamePath(from, cut)) {
+    return false;
+  }
+  // cutting after cut splits the path; the cycle is broken only if the two
+  // endpoints end up on different sides
+  return isUpTo(from, cut) != isUpTo(to, cut);
+}
+
+bool HamiltonianPathProblem::PathForestGraphicMatroidSet::tryAddElement(
+    int element) {
+  assert(element >= 0 && element < groundSetSize_);
+  int from = from_[element];
+  int to = to_[element];
+  if (next_[from] != -1) {
+    throw std::invalid_argument("Vertex already has an outgoing edge");
+  }
+  if (!canAdd(element)) {
+    // from is the tail and to is the head of the same path: a cycle
+    return false;
+  }
+  link(from, to);
+  return true;
+}
+
+void HamiltonianPathProblem::PathForestGraphicMatroidSet::link(int from,
+                                                                int to) {
+  // from is the last vertex of its path, so after splaying it has no right
+  // child; hang the path starting at to there
+  splay(from);
+  splay(to);
+  right_[from] = to;
+  parent_[to] = from;
+  next_[from] = to;
+}
+
+void HamiltonianPathProblem::PathForestGraphicMatroidSet::removeElement(
+    int element) {
+  assert(element >= 0 && element < groundSetSize_);
+  int from = from_[element];
+  int to = to_[element];
+  if (next_[from] != to) {
     throw std::invalid_argument("Edge not found");
   }
-  next_[edges_[element].first] = -1;
-}
\ No newline at end of file
+  // everything after from on the path is its right subtree once splayed
+  splay(from);
+  parent_[right_[from]] = -1;
+  right_[from] = -1;
+  next_[from] = -1;
+}
+
+void HamiltonianPathProblem::PathForestGraphicMatroidSet::restoreElement(
+    int element) {
+  assert(element >= 0 && element < groundSetSize_);
+  int from = from_[element];
+  int to = to_[element];
+  link(from, to);
+}
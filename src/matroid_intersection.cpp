@@ -1,23 +1,41 @@
 #include "matroid_intersection.h"
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <numeric>
 #include <random>
+#include <thread>
 
 ApproximationSolution::ApproximationSolution(double approximationRatio,
                                              std::vector<int> solution)
     : approximationRatio_(approximationRatio), solution_(std::move(solution)) {}
 
-BaselineAlgorithm::BaselineAlgorithm(
-    const std::shared_ptr<MatroidProblem> &matroidProblem)
+template <typename Problem>
+BasicBaselineAlgorithm<Problem>::BasicBaselineAlgorithm(
+    const std::shared_ptr<Problem> &matroidProblem)
     : matroidProblem_(matroidProblem) {}
 
-ApproximationSolution BaselineAlgorithm::run() {
+template <typename Problem>
+ApproximationSolution BasicBaselineAlgorithm<Problem>::run() {
   // 1/k approximation: greedily add elements that maintain independence
   std::vector<int> solution;
+  Deadline deadline = deadline_;
+  int edgesCount = matroidProblem_->getGroundSetSize();
+  bool ordered = !elementOrder_.empty();
+  if (ordered && static_cast<int>(elementOrder_.size()) != edgesCount) {
+    throw std::invalid_argument("The element order must cover the ground set");
+  }
 
-  for (int element = 0; element < matroidProblem_->getGroundSetSize();
-       element++) {
+  for (int i = 0; i < edgesCount; i++) {
+    if (deadline.expired()) {
+      throw DeadlineExceeded();
+    }
+    int element = ordered ? elementOrder_[i] : i;
     if (matroidProblem_->tryAddElement(element)) {
       solution.push_back(element);
     }
@@ -37,7 +55,7 @@ Kuhn2dMatchingAlgorithm::Kuhn2dMatchingAlgorithm(
 }
 
 ApproximationSolution Kuhn2dMatchingAlgorithm::run() {
-  // Hopcroft-Karp algorithm: find a maximum matching in a bipartite graph
+  // Kuhn's algorithm: find a maximum matching in a bipartite graph
   std::vector<int> solution;
   int n = matchingProblem_->getVertexPerPartitionCount();
 
@@ -45,11 +63,12 @@ ApproximationSolution Kuhn2dMatchingAlgorithm::run() {
   // <vertex, edge_index>
   std::vector<std::vector<std::pair<int, int>>> graph(n);
   const auto &edges = matchingProblem_->getEdges();
-  for (size_t edge_i = 0; edge_i < edges.size(); edge_i++) {
-    graph[edges[edge_i][0]].push_back({edges[edge_i][1], edge_i});
+  for (int edge_i = 0; edge_i < edges.size(); edge_i++) {
+    graph[edges.getVertex(edge_i, 0)].push_back(
+        {edges.getVertex(edge_i, 1), edge_i});
   }
 
-  // run Hopcroft-Karp algorithm
+  // run Kuhn's algorithm
   std::vector<int> match_vertex(n, -1); // right partition
   std::vector<int> match_edge(
       n, -1); // for matching recovery purposes, right partition
@@ -73,11 +92,15 @@ ApproximationSolution Kuhn2dMatchingAlgorithm::run() {
     return false;
   };
 
+  Deadline deadline = deadline_;
   bool any;
   do {
     any = false;
     std::fill(isVisited.begin(), isVisited.end(), false);
     for (int v = 0; v < n; v++) {
+      if (deadline.expired()) {
+        throw DeadlineExceeded();
+      }
       if (!isVisited[v] && !isMatched[v] && dfs(dfs, v))
         any = true;
     }
@@ -90,9 +113,302 @@ ApproximationSolution Kuhn2dMatchingAlgorithm::run() {
   return ApproximationSolution(1.0, solution);
 }
 
-LocalSearchAlgorithm::LocalSearchAlgorithm(
-    const std::shared_ptr<MatroidProblem> &matroidProblem, int timeLimitSeconds)
-    : matroidProblem_(matroidProblem), timeLimitSeconds_(timeLimitSeconds) {}
+HopcroftKarpMatchingAlgorithm::HopcroftKarpMatchingAlgorithm(
+    const std::shared_ptr<MatchingProblem> &matchingProblem)
+    : matchingProblem_(matchingProblem) {
+  // ensure that the graph is bipartite
+  if (matchingProblem_->getMatroidQuantity() != 2) {
+    throw std::invalid_argument("Graph must be bipartite");
+  }
+}
+
+ApproximationSolution HopcroftKarpMatchingAlgorithm::run() {
+  int n = matchingProblem_->getVertexPerPartitionCount();
+  const auto &edges = matchingProblem_->getEdges();
+  int edgesCount = edges.size();
+  const int *left = edges.getColumn(0);
+  const int *right = edges.getColumn(1);
+
+  // CSR adjacency of the left partition: the edges of left vertex u are
+  // adjacentEdge[offset[u] .. offset[u + 1])
+  std::vector<int> offset(n + 1, 0);
+  for (int edge_i = 0; edge_i < edgesCount; edge_i++) {
+    ++offset[left[edge_i] + 1];
+  }
+  for (int u = 0; u < n; u++) {
+    offset[u + 1] += offset[u];
+  }
+  std::vector<int> adjacentVertex(edgesCount);
+  std::vector<int> adjacentEdge(edgesCount);
+  {
+    std::vector<int> fill(offset.begin(), offset.end() - 1);
+    for (int edge_i = 0; edge_i < edgesCount; edge_i++) {
+      int slot = fill[left[edge_i]]++;
+      adjacentVertex[slot] = right[edge_i];
+      adjacentEdge[slot] = edge_i;
+    }
+  }
+
+  const int unreachable = -1;
+  std::vector<int> matchLeft(n, -1);  // left vertex -> matched CSR slot
+  std::vector<int> matchRight(n, -1); // right vertex -> matched left vertex
+  std::vector<int> dist(n);
+  std::vector<int> queue;
+  queue.reserve(n);
+  std::vector<int> nextSlot(n);
+  std::vector<int> stack;
+  phaseCount_ = 0;
+  Deadline deadline = deadline_;
+
+  while (true) {
+    if (deadline.expiredNow()) {
+      throw DeadlineExceeded();
+    }
+    // BFS layers over left vertices, starting from the free ones
+    queue.clear();
+    for (int u = 0; u < n; u++) {
+      if (matchLeft[u] == -1) {
+        dist[u] = 0;
+        queue.push_back(u);
+      } else {
+        dist[u] = unreachable;
+      }
+    }
+    // the layers end with the first one reaching a free right vertex, at
+    // freeDist, so that the phase only augments along shortest paths
+    int freeDist = unreachable;
+    for (size_t head = 0; head < queue.size(); head++) {
+      int u = queue[head];
+      if (freeDist != unreachable && dist[u] > freeDist) {
+        break;
+      }
+      for (int slot = offset[u]; slot < offset[u + 1]; slot++) {
+        int w = matchRight[adjacentVertex[slot]];
+        if (w == -1) {
+          freeDist = dist[u];
+        } else if (dist[w] == unreachable) {
+          dist[w] = dist[u] + 1;
+          queue.push_back(w);
+        }
+      }
+    }
+    if (freeDist == unreachable) {
+      break;
+    }
+    ++phaseCount_;
+
+    // iterative DFS along the layers; nextSlot[u] is the next CSR slot of u
+    // to try, and the stack holds the left vertices of the current path
+    std::copy(offset.begin(), offset.end() - 1, nextSlot.begin());
+    for (int root = 0; root < n; root++) {
+      if (matchLeft[root] != -1) {
+        continue;
+      }
+      if (deadline.expired()) {
+        throw DeadlineExceeded();
+      }
+      stack.assign(1, root);
+      while (!stack.empty()) {
+        int u = stack.back();
+        if (nextSlot[u] == offset[u + 1]) {
+          // dead end: drop u from the layered graph for this phase
+          dist[u] = unreachable;
+          stack.pop_back();
+          if (!stack.empty()) {
+            ++nextSlot[stack.back()];
+          }
+          continue;
+        }
+        int w = matchRight[adjacentVertex[nextSlot[u]]];
+        if (w == -1 && dist[u] == freeDist) {
+          // augment: every vertex on the stack takes its current slot
+          for (int v : stack) {
+            matchLeft[v] = nextSlot[v];
+            matchRight[adjacentVertex[nextSlot[v]]] = v;
+          }
+          break;
+        }
+        if (w != -1 && dist[u] < freeDist && dist[w] == dist[u] + 1) {
+          stack.push_back(w);
+        } else {
+          ++nextSlot[u];
+        }
+      }
+    }
+  }
+
+  std::vector<int> solution;
+  for (int u = 0; u < n; u++) {
+    if (matchLeft[u] != -1) {
+      solution.push_back(adjacentEdge[matchLeft[u]]);
+    }
+  }
+  return ApproximationSolution(1.0, solution);
+}
+
+ExchangeGraphIntersectionAlgorithm::ExchangeGraphIntersectionAlgorithm(
+    const std::shared_ptr<MatroidProblem> &matroidProblem)
+    : matroidProblem_(matroidProblem) {
+  if (matroidProblem_->getMatroidQuantity() != 2) {
+    throw std::invalid_argument("Exactly two matroids are required");
+  }
+}
+
+ApproximationSolution ExchangeGraphIntersectionAlgorithm::run() {
+  // Exchange graph for the current set I: a source is x not in I with
+  // I + x independent in M1, a sink is x with I + x independent in M2; there
+  // is an arc y -> x when I - y + x is independent in M1 and x -> y when it
+  // is independent in M2 (y in I, x not in I). A shortest source-sink path
+  // is an augmenting path. Distances never decrease, so in each phase the
+  // BFS layers are reused for several shortest paths, with the arcs checked
+  // against the current set while searching.
+  MatroidProblem &problem = *matroidProblem_;
+  const auto &first = problem.getMatroid(0);
+  const auto &second = problem.getMatroid(1);
+  int n = problem.getGroundSetSize();
+  phaseCount_ = 0;
+  augmentationCount_ = 0;
+  Deadline deadline = deadline_;
+
+  // paths of length zero: plain greedy
+  for (int element = 0; element < n; element++) {
+    if (deadline.expired()) {
+      throw DeadlineExceeded();
+    }
+    problem.tryAddElement(element);
+  }
+
+  auto isArc = [&](int from, int to) {
+    return problem.contains(from) ? first.canExchange(from, to)
+                                  : second.canExchange(to, from);
+  };
+
+  std::vector<int> dist(n);
+  std::vector<std::vector<int>> layers;
+  std::vector<int> unvisited[2]; // not yet labeled; outside / inside of I
+  std::vector<bool> isAlive(n);
+  std::vector<int> nextCandidate(n);
+  std::vector<int> path;
+  while (true) {
+    // BFS over the exchange graph up to the layer of the nearest sink
+    std::fill(dist.begin(), dist.end(), -1);
+    layers.clear();
+    layers.emplace_back();
+    unvisited[0].clear();
+    unvisited[1].clear();
+    for (int x = 0; x < n; x++) {
+      if (!problem.contains(x) && first.canAdd(x)) {
+        dist[x] = 0;
+        layers[0].push_back(x);
+      } else {
+        unvisited[problem.contains(x)].push_back(x);
+      }
+    }
+    int sinkLayer = -1;
+    for (int layer = 0; sinkLayer == -1 && !layers[layer].empty(); layer++) {
+      layers.emplace_back();
+      for (int v : layers[layer]) {
+        if (deadline.expired()) {
+          throw DeadlineExceeded();
+        }
+        if (!problem.contains(v) && second.canAdd(v)) {
+          sinkLayer = layer;
+          break;
+        }
+        // arcs only lead to the other side of I; labeled elements are
+        // swapped out of the unvisited list
+        auto &candidates = unvisited[!problem.contains(v)];
+        for (size_t i = 0; i < candidates.size();) {
+          int w = candidates[i];
+          if (isArc(v, w)) {
+            dist[w] = layer + 1;
+            layers[layer + 1].push_back(w);
+            candidates[i] = candidates.back();
+            candidates.pop_back();
+          } else {
+            ++i;
+          }
+        }
+      }
+    }
+    if (sinkLayer == -1) {
+      break;
+    }
+    ++phaseCount_;
+
+    // augment along shortest paths through the layers until none is left;
+    // each path is found with an iterative DFS and its vertices are retired
+    std::fill(isAlive.begin(), isAlive.end(), true);
+    std::fill(nextCandidate.begin(), nextCandidate.end(), 0);
+    for (int source : layers[0]) {
+      if (!isAlive[source] || !first.canAdd(source)) {
+        continue;
+      }
+      if (deadline.expired()) {
+        throw DeadlineExceeded();
+      }
+      path.assign(1, source);
+      while (!path.empty()) {
+        int v = path.back();
+        int layer = dist[v];
+        if (layer == sinkLayer) {
+          if (second.canAdd(v)) {
+            break;
+          }
+          isAlive[v] = false;
+          path.pop_back();
+          continue;
+        }
+        const auto &nextLayer = layers[layer + 1];
+        int &candidate = nextCandidate[v];
+        while (candidate < static_cast<int>(nextLayer.size()) &&
+               !(isAlive[nextLayer[candidate]] &&
+                 isArc(v, nextLayer[candidate]))) {
+          ++candidate;
+        }
+        if (candidate == static_cast<int>(nextLayer.size())) {
+          isAlive[v] = false;
+          path.pop_back();
+        } else {
+          path.push_back(nextLayer[candidate++]);
+        }
+      }
+      if (path.empty()) {
+        continue;
+      }
+      // I := I xor path; removing first keeps every intermediate set a
+      // subset of the (independent) result
+      for (int v : path) {
+        if (problem.contains(v)) {
+          problem.removeElement(v);
+        }
+      }
+      for (size_t i = 0; i < path.size(); i += 2) {
+        problem.addElement(path[i]);
+      }
+      for (int v : path) {
+        isAlive[v] = false;
+      }
+      ++augmentationCount_;
+    }
+  }
+  std::cerr << "Exchange graph: " << augmentationCount_
+            << " augmentations in " << phaseCount_ << " phases" << std::endl;
+
+  std::vector<int> solution;
+  for (int element = 0; element < n; element++) {
+    if (problem.contains(element)) {
+      solution.push_back(element);
+    }
+  }
+  return ApproximationSolution(1.0, solution);
+}
+
+template <typename Problem>
+BasicLocalSearchAlgorithm<Problem>::BasicLocalSearchAlgorithm(
+    const std::shared_ptr<Problem> &matroidProblem,
+    std::chrono::milliseconds timeLimit)
+    : matroidProblem_(matroidProblem), timeLimit_(timeLimit) {}
 
 double computeApproximationRatio(int s, int k) {
   if (s == 0)
@@ -116,77 +432,532 @@ std::vector<int> convertMaskToSolution(const std::vector<bool> &solutionMask) {
   return solution;
 }
 
-std::vector<ApproximationSolution> LocalSearchAlgorithm::run() {
-  std::vector<ApproximationSolution> solutions;
-  int edgesCount = matroidProblem_->getGroundSetSize();
-  std::vector<bool> solutionMask(edgesCount, false);
-  std::vector<bool> justRemoved(edgesCount, false);
-  auto startTime = std::chrono::steady_clock::now();
+namespace {
+
+// The membership mask of an initial solution, which is checked to be an
+// independent set of valid elements; the problem is left as it was
+template <typename Problem>
+std::vector<bool> checkInitialSolution(Problem &problem,
+                                       const std::vector<int> &solution) {
+  int edgesCount = problem.getGroundSetSize();
+  std::vector<bool> mask(edgesCount, false);
+  std::size_t checkpoint = problem.checkpoint();
+  bool independent = true;
+  for (int element : solution) {
+    if (element < 0 || element >= edgesCount) {
+      problem.rollback(checkpoint);
+      throw std::invalid_argument("Initial solution element out of range");
+    }
+    independent = independent && problem.tryAddElement(element);
+    mask[element] = true;
+  }
+  problem.rollback(checkpoint);
+  if (!independent) {
+    throw std::invalid_argument("The initial solution is not independent");
+  }
+  return mask;
+}
+
+// One exchange search over a problem: the current solution, the elements the
+// current attempt has removed and the shared stopping criteria. The parallel
+// mode keeps one per worker, each over its own clone of the problem.
+template <typename Problem> struct ExchangeSearch {
+  // candidates checked per canAddBatch call: two AVX2 gathers per partition
+  static constexpr int kAddBlockSize = 16;
+
+  Problem &problem;
+  const std::vector<int> &order;
+  Deadline deadline;
+  const std::atomic<bool> *cancelled; // set once another worker improved
+  std::vector<bool> solutionMask;
+  std::vector<bool> justRemoved;
   bool timeLimitExceeded = false;
+  std::int64_t attempts = 0;        // removal sets whose insertions were tried
+  std::int64_t candidateChecks = 0; // insertion candidates queried
+
+  // optional conflict index restricting insertions to the neighbourhood of
+  // the removed elements, with its scratch buffers
+  std::unique_ptr<PartitionConflictIndex> conflicts;
+  std::vector<int> position; // [E] index of the element in order
+  std::vector<int> removed;
+  std::vector<int> candidates;
+  std::vector<int> candidateStamp; // [E] last stamp the element was listed
+  int stamp = 0;
+
+  // The explicit stacks of the enumeration, grown to the deepest step so
+  // far and reused: its depth is the step, not the ground set size
+  struct AddFrame {
+    int block;              // first candidate of the block being scanned
+    int count;              // candidates in the block, 0 before the first
+    int next;               // next candidate of the block
+    std::uint32_t addable;  // canAddBatch answers for the block
+    std::size_t checkpoint; // before the current insertion
+
+    void start(int begin) {
+      block = begin;
+      count = 0;
+      next = 0;
+    }
+  };
+  struct RemovalFrame {
+    std::size_t member;     // index in members
+    std::size_t checkpoint; // before the removal
+  };
+  std::vector<AddFrame> addFrames;
+  std::vector<RemovalFrame> removalFrames;
+  std::vector<int> members; // positions in order of the solution members
+  bool membersStale = true;
+
+  ExchangeSearch(Problem &problem, const std::vector<int> &order,
+                 Deadline deadline,
+                 const PartitionConflictIndex *conflictIndex = nullptr,
+                 const std::atomic<bool> *cancelled = nullptr)
+      : problem(problem), order(order), deadline(deadline),
+        cancelled(cancelled),
+        solutionMask(problem.getGroundSetSize(), false),
+        justRemoved(problem.getGroundSetSize(), false) {
+    if (conflictIndex) {
+      conflicts = std::make_unique<PartitionConflictIndex>(*conflictIndex);
+      position.resize(order.size());
+      for (int idx = 0; idx < edgesCount(); idx++) {
+        position[order[idx]] = idx;
+      }
+      candidateStamp.assign(order.size(), 0);
+    }
+  }
+
+  int edgesCount() const { return static_cast<int>(order.size()); }
 
-  auto checkTimeLimit = [&]() -> bool {
-    auto currentTime = std::chrono::steady_clock::now();
-    auto elapsedSeconds = std::chrono::duration_cast<std::chrono::seconds>(
-                              currentTime - startTime)
-                              .count();
-    if (elapsedSeconds >= timeLimitSeconds_) {
+  // Polled on every step of the enumeration; the deadline reads the clock
+  // only once in a while
+  bool checkTimeLimit(bool now = false) {
+    if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+      return true;
+    }
+    if (now ? deadline.expiredNow() : deadline.expired()) {
       timeLimitExceeded = true;
       return true;
     }
     return false;
-  };
+  }
+
+  void add(int element) {
+    problem.addElement(element);
+    solutionMask[element] = true;
+    if (conflicts)
+      conflicts->addElement(element);
+  }
 
-  auto addElements = [&](auto self, int idx, int addQuantity) -> bool {
+  void remove(int element) {
+    problem.removeElement(element);
+    solutionMask[element] = false;
+    if (conflicts)
+      conflicts->removeElement(element);
+  }
+
+  // Take back the changes since the checkpoint, e.g. of a failed branch
+  void rollback(std::size_t checkpoint) {
+    problem.rollback(checkpoint, [this](int element, bool wasAdded) {
+      solutionMask[element] = !wasAdded;
+      if (conflicts) {
+        if (wasAdded)
+          conflicts->removeElement(element);
+        else
+          conflicts->addElement(element);
+      }
+    });
+  }
+
+  // Add addQuantity elements of elements, in order, backtracking over which
+  // ones. A failed branch restores the state exactly, so the canAdd answers
+  // of a whole block are computed once, in one batch. Iterative: level d of
+  // addFrames scans the candidates for the d-th insertion.
+  bool addElements(const std::vector<int> &elements, int addQuantity) {
     if (checkTimeLimit()) {
       return false;
     }
     if (addQuantity == 0) {
       return true;
     }
-    if (idx == edgesCount) {
-      return false;
+    if (static_cast<int>(addFrames.size()) < addQuantity) {
+      addFrames.resize(addQuantity);
     }
-    if (justRemoved[idx] || solutionMask[idx])
-      return self(self, idx + 1, addQuantity);
-    if (matroidProblem_->tryAddElement(idx)) {
-      solutionMask[idx] = true;
-      if (self(self, idx + 1, addQuantity - 1))
+    int size = static_cast<int>(elements.size());
+    int depth = 0;
+    addFrames[0].start(0);
+    for (;;) {
+      AddFrame &frame = addFrames[depth];
+      if (frame.next == frame.count) {
+        frame.block += frame.count;
+        if (frame.block >= size) {
+          // no candidate left at this level: take back the insertion of the
+          // level above and go on with its next candidate
+          if (depth == 0) {
+            return false;
+          }
+          rollback(addFrames[--depth].checkpoint);
+          if (timeLimitExceeded || checkTimeLimit()) {
+            if (depth > 0) {
+              rollback(addFrames[0].checkpoint);
+            }
+            return false;
+          }
+          continue;
+        }
+        frame.count = std::min(kAddBlockSize, size - frame.block);
+        frame.next = 0;
+        candidateChecks += frame.count;
+        // rejected candidates are only read, never written and rolled back
+        frame.addable = problem.canAddBatch(
+            &elements[frame.block], frame.count,
+            (std::uint32_t{1} << frame.count) - 1);
+      }
+      int i = frame.next++;
+      int element = elements[frame.block + i];
+      if (!((frame.addable >> i) & 1) || justRemoved[element])
+        continue;
+      frame.checkpoint = problem.checkpoint();
+      add(element);
+      if (checkTimeLimit()) {
+        rollback(addFrames[0].checkpoint);
+        return false;
+      }
+      if (depth + 1 == addQuantity) {
+        problem.commit(addFrames[0].checkpoint);
         return true;
-      matroidProblem_->removeElement(idx);
-      solutionMask[idx] = false;
+      }
+      addFrames[++depth].start(frame.block + i + 1);
     }
-    return self(self, idx + 1, addQuantity);
-  };
-  auto removeAndAddElements = [&](auto self, int idx, int removeQuantity,
-                                  int addQuantity) -> bool {
-    if (checkTimeLimit()) {
+  }
+
+  // How the insertions are enumerated once the removal set is complete. The
+  // solution was maximal before the removals (the attempt without removals
+  // comes first and failed), so only elements touching a vertex freed by a
+  // removed element can enter: these, in scan order, are the candidates.
+  bool addAfterRemovals(int addQuantity) {
+    ++attempts;
+    if (!conflicts || removed.empty()) {
+      return addElements(order, addQuantity);
+    }
+    candidates.clear();
+    ++stamp;
+    for (int element : removed) {
+      size_t begin = candidates.size();
+      conflicts->appendNeighbours(element, candidates);
+      size_t kept = begin;
+      for (size_t i = begin; i < candidates.size(); i++) {
+        int candidate = candidates[i];
+        if (candidateStamp[candidate] != stamp && !justRemoved[candidate] &&
+            !solutionMask[candidate] && conflicts->isFree(candidate)) {
+          candidateStamp[candidate] = stamp;
+          candidates[kept++] = candidate;
+        }
+      }
+      candidates.resize(kept);
+    }
+    if (static_cast<int>(candidates.size()) < addQuantity) {
       return false;
     }
-    if (removeQuantity == 0)
-      return addElements(addElements, 0, addQuantity);
-    if (idx == edgesCount) {
+    std::sort(candidates.begin(), candidates.end(), [&](int a, int b) {
+      return position[a] < position[b];
+    });
+    return addElements(candidates, addQuantity);
+  }
+
+  // Remove removeQuantity elements of the solution and add addQuantity
+  bool removeAndAddElements(int removeQuantity, int addQuantity) {
+    return enumerateRemovals(0, false, removeQuantity, addQuantity);
+  }
+
+  // the removal combinations whose first removed element is order[idx], a
+  // member of the solution
+  bool removeFirstAndAddElements(int idx, int removeQuantity,
+                                 int addQuantity) {
+    refreshMembers();
+    std::size_t first =
+        std::lower_bound(members.begin(), members.end(), idx) -
+        members.begin();
+    return enumerateRemovals(first, true, removeQuantity, addQuantity);
+  }
+
+  // The removal sets of removeQuantity members among members[first..] (or
+  // those starting with members[first], if firstFixed), in the order of
+  // their positions, each followed by the insertions. Iterative: level d of
+  // removalFrames holds the d-th removed member.
+  bool enumerateRemovals(std::size_t first, bool firstFixed,
+                         int removeQuantity, int addQuantity) {
+    if (checkTimeLimit()) {
       return false;
     }
-    if (solutionMask[idx]) {
-      matroidProblem_->removeElement(idx);
-      solutionMask[idx] = false;
-      justRemoved[idx] = true;
-      if (self(self, idx + 1, removeQuantity - 1, addQuantity))
+    if (removeQuantity == 0) {
+      if (!addAfterRemovals(addQuantity)) {
+        return false;
+      }
+      membersStale = true;
+      return true;
+    }
+    refreshMembers();
+    if (static_cast<int>(removalFrames.size()) < removeQuantity) {
+      removalFrames.resize(removeQuantity);
+    }
+    std::size_t memberCount = members.size();
+    int depth = 0;
+    std::size_t next = first;
+    for (;;) {
+      // next is the candidate for the removal at depth, unless too few
+      // members are left after it
+      if (next + (removeQuantity - depth) > memberCount ||
+          (firstFixed && depth == 0 && next > first)) {
+        if (depth == 0) {
+          return false;
+        }
+        --depth;
+        undoRemovals(depth, depth + 1);
+        next = removalFrames[depth].member + 1;
+        continue;
+      }
+      if (checkTimeLimit()) {
+        if (depth > 0) {
+          undoRemovals(0, depth);
+        }
+        return false;
+      }
+      RemovalFrame &frame = removalFrames[depth];
+      frame.member = next;
+      frame.checkpoint = problem.checkpoint();
+      int element = order[members[next]];
+      remove(element);
+      justRemoved[element] = true;
+      removed.push_back(element);
+      ++depth;
+      ++next;
+      if (depth < removeQuantity) {
+        continue;
+      }
+      if (!checkTimeLimit() && addAfterRemovals(addQuantity)) {
+        problem.commit(removalFrames[0].checkpoint);
+        membersStale = true;
         return true;
-      justRemoved[idx] = false;
-      if (!matroidProblem_->tryAddElement(idx))
-        throw std::runtime_error("Failed to add element");
-      solutionMask[idx] = true;
+      }
+      // take back the last removal and try the next member in its place
+      --depth;
+      undoRemovals(depth, depth + 1);
     }
-    return self(self, idx + 1, removeQuantity, addQuantity);
+  }
+
+  // Take back the removals of levels from..depth - 1, newest first; the
+  // state is back to where they were part of the solution
+  void undoRemovals(int from, int depth) {
+    for (int level = depth - 1; level >= from; level--) {
+      justRemoved[removed.back()] = false;
+      removed.pop_back();
+    }
+    rollback(removalFrames[from].checkpoint);
+  }
+
+  // Positions in order of the solution members, rebuilt once the solution
+  // has changed; a failed enumeration restores the solution, so they stay
+  // valid throughout one
+  void refreshMembers() {
+    if (!membersStale) {
+      return;
+    }
+    members.clear();
+    for (int idx = 0; idx < edgesCount(); idx++) {
+      if (solutionMask[order[idx]]) {
+        members.push_back(idx);
+      }
+    }
+    membersStale = false;
+  }
+
+  // Bring the problem to the given solution, e.g. another worker's
+  void syncTo(const std::vector<bool> &target) {
+    for (int element = 0; element < edgesCount(); element++) {
+      if (solutionMask[element] && !target[element]) {
+        remove(element);
+      }
+    }
+    for (int element = 0; element < edgesCount(); element++) {
+      if (!solutionMask[element] && target[element]) {
+        add(element);
+      }
+    }
+    membersStale = true;
+    resetAttempt();
+  }
+
+  // Forget the removals of the last (successful) attempt
+  void resetAttempt() {
+    std::fill(justRemoved.begin(), justRemoved.end(), false);
+    removed.clear();
+  }
+};
+
+// Work-stealing task queues: every worker pops its own tasks from the back of
+// its deque and steals from the front of the others' once it runs dry
+class WorkStealingQueues {
+public:
+  explicit WorkStealingQueues(int workerCount)
+      : tasks_(workerCount), mutexes_(workerCount) {}
+
+  void push(int worker, int task) { tasks_[worker].push_back(task); }
+
+  bool pop(int worker, int &task) {
+    {
+      std::lock_guard<std::mutex> lock(mutexes_[worker]);
+      if (!tasks_[worker].empty()) {
+        task = tasks_[worker].back();
+        tasks_[worker].pop_back();
+        return true;
+      }
+    }
+    int workerCount = static_cast<int>(tasks_.size());
+    for (int i = 1; i < workerCount; i++) {
+      int victim = (worker + i) % workerCount;
+      std::lock_guard<std::mutex> lock(mutexes_[victim]);
+      if (!tasks_[victim].empty()) {
+        task = tasks_[victim].front();
+        tasks_[victim].pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  std::vector<std::deque<int>> tasks_;
+  std::vector<std::mutex> mutexes_;
+};
+
+} // namespace
+
+template <typename Problem>
+std::vector<ApproximationSolution> BasicLocalSearchAlgorithm<Problem>::run() {
+  std::vector<ApproximationSolution> solutions;
+  int edgesCount = matroidProblem_->getGroundSetSize();
+  std::vector<int> order = elementOrder_;
+  if (order.empty()) {
+    order.resize(edgesCount);
+    std::iota(order.begin(), order.end(), 0);
+  }
+  improvements_ = 0;
+  trace_.clear();
+  stepSeconds_.clear();
+  auto startTime = std::chrono::steady_clock::now();
+  auto secondsSinceStart = [&startTime]() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         startTime)
+        .count();
   };
+  Deadline deadline = deadline_.within(timeLimit_);
+  ExchangeSearch<Problem> search(*matroidProblem_, order, deadline,
+                                 conflictIndex_.get());
+  const auto &solutionMask = search.solutionMask;
+  bool &timeLimitExceeded = search.timeLimitExceeded;
+
+  // with several threads, every worker searches its own clone of the
+  // problem, kept in sync with the main one after each improvement
+  std::atomic<bool> improved{false};
+  std::vector<std::shared_ptr<Problem>> workerProblems;
+  std::vector<ExchangeSearch<Problem>> workers;
+  for (int t = 0; threadCount_ > 1 && t < threadCount_; t++) {
+    workerProblems.push_back(matroidProblem_->clone());
+    workerProblems.back()->resetOracleCounters(); // merged in at the end
+  }
+  for (const auto &problem : workerProblems) {
+    workers.emplace_back(*problem, order, deadline, conflictIndex_.get(),
+                         &improved);
+  }
 
+  // a warm start skips step 0; the first attempt of step 1 (no removals)
+  // completes the initial solution if it isn't maximal
+  int firstStep = 0;
   int solutionSize = 0;
-  for (int s = 0;; ++s) {
+  if (!initialSolution_.empty()) {
+    std::vector<bool> initialMask =
+        checkInitialSolution(*matroidProblem_, initialSolution_);
+    search.syncTo(initialMask);
+    for (auto &worker : workers) {
+      worker.syncTo(initialMask);
+    }
+    firstStep = 1;
+    solutionSize = static_cast<int>(initialSolution_.size());
+  }
+
+  // Tries to remove removeQuantity elements and add one more than that; the
+  // removal combinations are split by their first removed element into
+  // tasks for the workers, and the first improvement found cancels the rest
+  auto tryImprove = [&](int removeQuantity) -> bool {
+    if (workers.empty() || removeQuantity == 0) {
+      if (!search.removeAndAddElements(removeQuantity, removeQuantity + 1))
+        return false;
+      for (auto &worker : workers) {
+        worker.syncTo(solutionMask);
+      }
+      return true;
+    }
+    int workerCount = static_cast<int>(workers.size());
+    WorkStealingQueues queues(workerCount);
+    int taskCount = 0;
+    for (int idx = 0; idx < edgesCount; idx++) {
+      if (solutionMask[order[idx]]) {
+        queues.push(taskCount++ % workerCount, idx);
+      }
+    }
+    improved = false;
+    std::atomic<int> winner{-1};
+    std::vector<std::exception_ptr> errors(workerCount);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < workerCount; t++) {
+      threads.emplace_back([&, t]() {
+        try {
+          int idx;
+          while (!improved && queues.pop(t, idx)) {
+            if (workers[t].removeFirstAndAddElements(idx, removeQuantity,
+                                                     removeQuantity + 1)) {
+              int none = -1;
+              winner.compare_exchange_strong(none, t);
+              improved = true;
+            }
+            if (workers[t].timeLimitExceeded)
+              break;
+          }
+        } catch (...) {
+          errors[t] = std::current_exception();
+          improved = true;
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    for (const auto &error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+    for (const auto &worker : workers) {
+      timeLimitExceeded = timeLimitExceeded || worker.timeLimitExceeded;
+    }
+    if (winner == -1) {
+      return false;
+    }
+    // copy the winner's solution: syncing it to itself would be a no-op
+    std::vector<bool> improvedMask = workers[winner].solutionMask;
+    search.syncTo(improvedMask);
+    for (auto &worker : workers) {
+      worker.syncTo(improvedMask);
+    }
+    return true;
+  };
+
+  for (int s = firstStep;; ++s) {
     // Check time limit before starting a new step
-    if (checkTimeLimit()) {
-      std::cerr << "Time limit of " << timeLimitSeconds_
-                << " seconds reached at step " << s << std::endl;
+    if (search.checkTimeLimit(true)) {
+      if (verbose_)
+        std::cerr << "Time limit of " << timeLimit_.count() / 1000.0
+                  << " seconds reached at step " << s << std::endl;
       break;
     }
     // trying to remove s and add s+1 elements
@@ -196,13 +967,24 @@ std::vector<ApproximationSolution> LocalSearchAlgorithm::run() {
         break;
       }
       success = false;
-      std::fill(justRemoved.begin(), justRemoved.end(), false);
+      search.resetAttempt();
       for (int i = 0; i <= s; ++i) {
         if (timeLimitExceeded) {
           break;
         }
-        if (removeAndAddElements(removeAndAddElements, 0, i, i + 1)) {
+        if (tryImprove(i)) {
           ++solutionSize;
+          ++improvements_;
+          // step 0 only makes greedy insertions, one per solution element:
+          // stepSeconds_ tells when it ends
+          if (s > 0) {
+            std::int64_t candidateChecks = search.candidateChecks;
+            for (const auto &worker : workers) {
+              candidateChecks += worker.candidateChecks;
+            }
+            trace_.push_back({secondsSinceStart(), s, i, i + 1, solutionSize,
+                              candidateChecks});
+          }
           success = true;
           break;
         }
@@ -213,18 +995,21 @@ std::vector<ApproximationSolution> LocalSearchAlgorithm::run() {
       }
     } while (success && !timeLimitExceeded);
     if (timeLimitExceeded) {
-      std::cerr << "Time limit of " << timeLimitSeconds_
-                << " seconds reached at step " << s << std::endl;
-      std::cerr << "Solution size: " << solutionSize << std::endl;
       double ratio;
-      if (s == 0)
+      if (s == firstStep)
         ratio = 0.0;
       else
         ratio = computeApproximationRatio(
             s - 1, matroidProblem_->getMatroidQuantity());
-      std::cerr << "Approximation ratio: " << ratio << std::endl;
+      if (verbose_) {
+        std::cerr << "Time limit of " << timeLimit_.count() / 1000.0
+                  << " seconds reached at step " << s << std::endl;
+        std::cerr << "Solution size: " << solutionSize << std::endl;
+        std::cerr << "Approximation ratio: " << ratio << std::endl;
+      }
       solutions.push_back(
           ApproximationSolution(ratio, convertMaskToSolution(solutionMask)));
+      stepSeconds_.push_back(secondsSinceStart());
       break;
     } else {
       // we can provide a guaranteed approximation ratio at this step for s
@@ -235,11 +1020,624 @@ std::vector<ApproximationSolution> LocalSearchAlgorithm::run() {
       }
       solutions.push_back(
           ApproximationSolution(ratio, convertMaskToSolution(solutionMask)));
+      stepSeconds_.push_back(secondsSinceStart());
       if (s == solutionSize)
         break;
     }
-    std::cerr << "At step " << s << " we found a solution of size "
-              << solutionSize << std::endl;
+    if (verbose_)
+      std::cerr << "At step " << s << " we found a solution of size "
+                << solutionSize << std::endl;
+    if (s == maxStep_)
+      break;
+  }
+  exchangeAttempts_ = search.attempts;
+  candidateChecks_ = search.candidateChecks;
+  for (const auto &worker : workers) {
+    exchangeAttempts_ += worker.attempts;
+    candidateChecks_ += worker.candidateChecks;
+  }
+  for (const auto &problem : workerProblems) {
+    matroidProblem_->mergeOracleCounters(problem->getOracleCounters());
   }
   return solutions;
-}
\ No newline at end of file
+}
+
+template <typename Problem>
+BasicParallelLocalSearchAlgorithm<Problem>::BasicParallelLocalSearchAlgorithm(
+    const std::shared_ptr<Problem> &matroidProblem,
+    std::chrono::milliseconds timeLimit, int threadCount, unsigned int seed)
+    : matroidProblem_(matroidProblem), timeLimit_(timeLimit),
+      threadCount_(threadCount), seed_(seed) {
+  if (threadCount_ < 1) {
+    throw std::invalid_argument("At least one thread is required");
+  }
+}
+
+template <typename Problem>
+ApproximationSolution BasicParallelLocalSearchAlgorithm<Problem>::run() {
+  int edgesCount = matroidProblem_->getGroundSetSize();
+  threadStatistics_.assign(threadCount_, ThreadStatistics{});
+  std::vector<std::vector<ApproximationSolution>> results(threadCount_);
+  std::vector<std::exception_ptr> errors(threadCount_);
+
+  // clone up front: copying the source is not safe while another thread
+  // queries it
+  std::vector<std::shared_ptr<Problem>> problems;
+  for (int t = 0; t < threadCount_; t++) {
+    problems.push_back(matroidProblem_->clone());
+    problems.back()->resetOracleCounters(); // merged in at the end
+  }
+
+  auto worker = [&](int t) {
+    try {
+      auto startTime = std::chrono::steady_clock::now();
+      unsigned int seed = seed_ + t;
+      std::vector<int> order(edgesCount);
+      std::iota(order.begin(), order.end(), 0);
+      if (t > 0) {
+        std::mt19937 rng(seed);
+        std::shuffle(order.begin(), order.end(), rng);
+      }
+      BasicLocalSearchAlgorithm<Problem> localSearch(problems[t], timeLimit_);
+      localSearch.setElementOrder(std::move(order));
+      localSearch.setDeadline(deadline_);
+      localSearch.setConflictIndex(conflictIndex_);
+      localSearch.setInitialSolution(initialSolution_);
+      localSearch.setVerbose(false);
+      results[t] = localSearch.run();
+
+      auto &statistics = threadStatistics_[t];
+      statistics.seed = seed;
+      statistics.completedSteps = static_cast<int>(results[t].size());
+      if (!results[t].empty()) {
+        statistics.solutionSize =
+            static_cast<int>(results[t].back().getSolution().size());
+        statistics.approximationRatio =
+            results[t].back().getApproximationRatio();
+      }
+      statistics.trace = localSearch.getTrace();
+      statistics.elapsedSeconds = std::chrono::duration<double>(
+                                      std::chrono::steady_clock::now() -
+                                      startTime)
+                                      .count();
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount_; t++) {
+    threads.emplace_back(worker, t);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (const auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  for (const auto &problem : problems) {
+    matroidProblem_->mergeOracleCounters(problem->getOracleCounters());
+  }
+
+  // each thread's last solution is its largest one
+  int best = -1;
+  for (int t = 0; t < threadCount_; t++) {
+    if (!results[t].empty() &&
+        (best == -1 || threadStatistics_[t].solutionSize >
+                           threadStatistics_[best].solutionSize)) {
+      best = t;
+    }
+  }
+  if (best == -1) {
+    return ApproximationSolution(0.0, {});
+  }
+  std::cerr << "Multi-start local search: best solution of size "
+            << threadStatistics_[best].solutionSize << " found by thread "
+            << best << " of " << threadCount_ << std::endl;
+  return results[best].back();
+}
+
+template <typename Problem>
+BasicWeightedLocalSearchAlgorithm<Problem>::BasicWeightedLocalSearchAlgorithm(
+    const std::shared_ptr<Problem> &matroidProblem,
+    std::shared_ptr<const PartitionConflictIndex> conflictIndex,
+    std::chrono::milliseconds timeLimit)
+    : matroidProblem_(matroidProblem),
+      conflictIndex_(std::move(conflictIndex)), timeLimit_(timeLimit) {
+  if (!conflictIndex_) {
+    throw std::invalid_argument("Weighted local search needs a conflict index");
+  }
+}
+
+template <typename Problem>
+ApproximationSolution BasicWeightedLocalSearchAlgorithm<Problem>::run() {
+  Problem &problem = *matroidProblem_;
+  int edgesCount = problem.getGroundSetSize();
+  Deadline deadline = deadline_.within(timeLimit_);
+  PartitionConflictIndex conflicts = *conflictIndex_;
+  std::vector<bool> solutionMask(edgesCount, false);
+  if (!initialSolution_.empty()) {
+    solutionMask = checkInitialSolution(problem, initialSolution_);
+    for (int element : initialSolution_) {
+      problem.addElement(element);
+      conflicts.addElement(element);
+    }
+  }
+  improvements_ = 0;
+  gainEvaluations_ = 0;
+  roundCount_ = 0;
+
+  // gains up to a tolerance relative to the largest weight count as none, so
+  // that rounding can't make the search cycle
+  double maxWeight = problem.isWeighted() ? 0.0 : 1.0;
+  for (int element = 0; problem.isWeighted() && element < edgesCount;
+       element++) {
+    maxWeight = std::max(maxWeight, problem.getWeight(element));
+  }
+  const double tolerance = 1e-9 * maxWeight;
+
+  // Gain of the swap of element: in for its conflicts, which are left in
+  // conflicting, after which the vertices they free are refilled with the
+  // heaviest elements free there, left in refilling. It is simulated on the
+  // conflict index, which is then restored.
+  std::vector<int> conflicting;
+  std::vector<int> refilling;
+  std::vector<int> candidates;
+  auto heavierFirst = [&problem](int a, int b) {
+    double weightA = problem.getWeight(a);
+    double weightB = problem.getWeight(b);
+    return weightA > weightB || (weightA == weightB && a < b);
+  };
+  auto evaluate = [&](int element) {
+    ++gainEvaluations_;
+    conflicting.clear();
+    refilling.clear();
+    conflicts.appendConflicts(element, conflicting);
+    double gain = problem.getWeight(element);
+    if (conflicting.empty()) {
+      return gain;
+    }
+    candidates.clear();
+    for (int conflict : conflicting) {
+      gain -= problem.getWeight(conflict);
+      conflicts.removeElement(conflict);
+      conflicts.appendNeighbours(conflict, candidates);
+    }
+    conflicts.addElement(element);
+    std::sort(candidates.begin(), candidates.end(), heavierFirst);
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+    for (int candidate : candidates) {
+      // the conflicts are still in the mask, and element covers its vertices
+      if (!solutionMask[candidate] && conflicts.isFree(candidate)) {
+        conflicts.addElement(candidate);
+        refilling.push_back(candidate);
+        gain += problem.getWeight(candidate);
+      }
+    }
+    for (int refill : refilling) {
+      conflicts.removeElement(refill);
+    }
+    conflicts.removeElement(element);
+    for (int conflict : conflicting) {
+      conflicts.addElement(conflict);
+    }
+    return gain;
+  };
+
+  // max-heap by gain, ties to the smaller element; an entry is stale once
+  // its element's gain has changed, and is then re-pushed or dropped
+  struct Candidate {
+    double gain;
+    int element;
+    bool operator<(const Candidate &other) const {
+      return gain < other.gain ||
+             (gain == other.gain && element > other.element);
+    }
+  };
+  std::vector<Candidate> heap;
+  auto push = [&heap](double gain, int element) {
+    heap.push_back({gain, element});
+    std::push_heap(heap.begin(), heap.end());
+  };
+
+  // the elements whose gain may have changed unseen since the heap was
+  // seeded, or whose swap the problem rejected; the next round seeds the
+  // heap from them alone
+  std::vector<bool> isPending(edgesCount, false);
+  std::vector<int> pending;
+  auto markPending = [&](int element) {
+    if (!isPending[element]) {
+      isPending[element] = true;
+      pending.push_back(element);
+    }
+  };
+  auto seed = [&](int element) {
+    if (!solutionMask[element]) {
+      double gain = evaluate(element);
+      if (gain > tolerance) {
+        heap.push_back({gain, element});
+      }
+    }
+  };
+
+  std::vector<int> refilled;
+  std::vector<int> touched;
+  std::vector<int> touchedConflicts;
+  bool timeLimitExceeded = false;
+  while (!timeLimitExceeded) {
+    heap.clear();
+    if (roundCount_++ == 0) {
+      for (int element = 0; element < edgesCount; element++) {
+        if (deadline.expired()) {
+          timeLimitExceeded = true;
+          break;
+        }
+        seed(element);
+      }
+    } else {
+      std::sort(pending.begin(), pending.end());
+      for (int element : pending) {
+        isPending[element] = false;
+        if (!timeLimitExceeded && deadline.expired()) {
+          timeLimitExceeded = true;
+        }
+        if (!timeLimitExceeded) {
+          seed(element);
+        }
+      }
+      pending.clear();
+    }
+    if (timeLimitExceeded) {
+      break;
+    }
+    std::make_heap(heap.begin(), heap.end());
+    std::int64_t roundImprovements = 0;
+    while (!heap.empty()) {
+      if (deadline.expired()) {
+        timeLimitExceeded = true;
+        break;
+      }
+      std::pop_heap(heap.begin(), heap.end());
+      Candidate candidate = heap.back();
+      heap.pop_back();
+      if (solutionMask[candidate.element]) {
+        continue;
+      }
+      double gain = evaluate(candidate.element);
+      if (gain < candidate.gain) {
+        if (gain > tolerance) {
+          push(gain, candidate.element);
+        }
+        continue;
+      }
+      // the problem has the last word: it may reject the element or a refill
+      // that the index accepts
+      std::size_t checkpoint = problem.checkpoint();
+      double appliedGain = problem.getWeight(candidate.element);
+      for (int conflict : conflicting) {
+        problem.removeElement(conflict);
+        appliedGain -= problem.getWeight(conflict);
+      }
+      if (!problem.canAdd(candidate.element)) {
+        problem.rollback(checkpoint);
+        markPending(candidate.element);
+        continue;
+      }
+      problem.addElement(candidate.element);
+      refilled.clear();
+      for (int refill : refilling) {
+        if (problem.tryAddElement(refill)) {
+          refilled.push_back(refill);
+          appliedGain += problem.getWeight(refill);
+        }
+      }
+      if (appliedGain <= tolerance) {
+        problem.rollback(checkpoint);
+        markPending(candidate.element);
+        continue;
+      }
+      problem.commit(checkpoint);
+      ++improvements_;
+      ++roundImprovements;
+
+      // the conflicts only change for the elements sharing a vertex with a
+      // moved one, the moved ones included; those are re-evaluated. The
+      // refills also change for the elements whose conflicts share a vertex
+      // with one of those, which can be most of a dense instance: they wait
+      // for the next round
+      touched.clear();
+      for (int conflict : conflicting) {
+        conflicts.removeElement(conflict);
+        solutionMask[conflict] = false;
+        conflicts.appendNeighbours(conflict, touched);
+      }
+      refilled.push_back(candidate.element);
+      for (int added : refilled) {
+        conflicts.addElement(added);
+        solutionMask[added] = true;
+        conflicts.appendNeighbours(added, touched);
+      }
+      std::sort(touched.begin(), touched.end());
+      touched.erase(std::unique(touched.begin(), touched.end()),
+                    touched.end());
+      for (int element : touched) {
+        if (deadline.expired()) {
+          break; // the swap is made; the loop above stops the run
+        }
+        if (!solutionMask[element]) {
+          double touchedGain = evaluate(element);
+          if (touchedGain > tolerance) {
+            push(touchedGain, element);
+          }
+        }
+      }
+      touchedConflicts.clear();
+      for (int element : touched) {
+        conflicts.appendConflicts(element, touchedConflicts);
+      }
+      std::sort(touchedConflicts.begin(), touchedConflicts.end());
+      touchedConflicts.erase(
+          std::unique(touchedConflicts.begin(), touchedConflicts.end()),
+          touchedConflicts.end());
+      for (int conflict : touchedConflicts) {
+        std::size_t begin = touched.size();
+        conflicts.appendNeighbours(conflict, touched);
+        for (std::size_t i = begin; i < touched.size(); i++) {
+          if (!solutionMask[touched[i]]) {
+            markPending(touched[i]);
+          }
+        }
+      }
+    }
+    // a round without swaps ends at a local optimum; otherwise the pending
+    // gains may have grown, or a rejected swap become possible
+    if (roundImprovements == 0) {
+      break;
+    }
+  }
+
+  bool coversEveryMatroid =
+      conflicts.getGraphRank() == problem.getMatroidQuantity();
+  double ratio = timeLimitExceeded || !coversEveryMatroid
+                     ? 0.0
+                     : 1.0 / problem.getMatroidQuantity();
+  return ApproximationSolution(ratio, convertMaskToSolution(solutionMask));
+}
+
+template <typename Problem>
+BasicSamplingLocalSearchAlgorithm<Problem>::BasicSamplingLocalSearchAlgorithm(
+    const std::shared_ptr<Problem> &matroidProblem,
+    std::chrono::milliseconds timeLimit, unsigned int seed)
+    : matroidProblem_(matroidProblem), timeLimit_(timeLimit), seed_(seed) {}
+
+template <typename Problem>
+ApproximationSolution BasicSamplingLocalSearchAlgorithm<Problem>::run() {
+  if (maxRemovals_ < 1) {
+    throw std::invalid_argument("A sample must remove at least one element");
+  }
+  if (initialAcceptance_ < 0 || initialAcceptance_ > 1 || cooling_ < 0 ||
+      cooling_ > 1) {
+    throw std::invalid_argument(
+        "The annealing acceptance and cooling must lie in [0, 1]");
+  }
+  Problem &problem = *matroidProblem_;
+  int edgesCount = problem.getGroundSetSize();
+  auto start = std::chrono::steady_clock::now();
+  Deadline deadline = deadline_.within(timeLimit_);
+  std::mt19937 rng(seed_);
+  auto uniform = [&rng](int size) {
+    return std::uniform_int_distribution<int>(0, size - 1)(rng);
+  };
+  std::uniform_real_distribution<double> coin(0.0, 1.0);
+  std::unique_ptr<PartitionConflictIndex> conflicts;
+  if (conflictIndex_) {
+    conflicts = std::make_unique<PartitionConflictIndex>(*conflictIndex_);
+  }
+  samples_ = 0;
+  improvements_ = 0;
+  plateauMoves_ = 0;
+  restarts_ = 0;
+
+  // the solution as a list, for drawing its elements, and each member's
+  // position in it, -1 for the others; kept in step with the problem and the
+  // index by add, remove and the rollbacks
+  std::vector<int> members;
+  std::vector<int> position(edgesCount, -1);
+  auto insertMember = [&](int element) {
+    position[element] = static_cast<int>(members.size());
+    members.push_back(element);
+    if (conflicts) {
+      conflicts->addElement(element);
+    }
+  };
+  auto eraseMember = [&](int element) {
+    int last = members.back();
+    members[position[element]] = last;
+    position[last] = position[element];
+    members.pop_back();
+    position[element] = -1;
+    if (conflicts) {
+      conflicts->removeElement(element);
+    }
+  };
+  auto add = [&](int element) {
+    problem.addElement(element);
+    insertMember(element);
+  };
+  auto remove = [&](int element) {
+    problem.removeElement(element);
+    eraseMember(element);
+  };
+  auto rollback = [&](std::size_t checkpoint) {
+    problem.rollback(checkpoint, [&](int element, bool wasAdded) {
+      if (wasAdded) {
+        eraseMember(element);
+      } else {
+        insertMember(element);
+      }
+    });
+  };
+
+  if (!initialSolution_.empty()) {
+    checkInitialSolution(problem, initialSolution_);
+    for (int element : initialSolution_) {
+      add(element);
+    }
+  }
+  std::vector<int> order(edgesCount);
+  std::iota(order.begin(), order.end(), 0);
+  // completes the solution greedily in order, so it is maximal
+  auto fill = [&]() {
+    for (int element : order) {
+      if (position[element] == -1 && problem.canAdd(element)) {
+        add(element);
+      }
+    }
+  };
+  fill();
+
+  std::vector<int> best = members;
+  std::int64_t sinceBest = 0;
+  double acceptance = initialAcceptance_;
+  std::vector<int> removed;
+  std::vector<int> candidates;
+  std::vector<int> owners;
+  while (maxSamples_ < 0 || samples_ < maxSamples_) {
+    if (members.empty() || deadline.expired()) {
+      break;
+    }
+    ++samples_;
+    int removals =
+        1 + uniform(std::min(maxRemovals_, static_cast<int>(members.size())));
+    std::size_t checkpoint = problem.checkpoint();
+    removed.clear();
+    int first = members[uniform(members.size())];
+    remove(first);
+    removed.push_back(first);
+    if (conflicts) {
+      // grow a cluster: the owners of a random neighbour of a removed element
+      // conflict with it, so the neighbour may enter once both are out; a
+      // bounded number of tries, as a neighbour may be free or removed-only
+      for (int tries = 0;
+           static_cast<int>(removed.size()) < removals && tries < 4 * removals;
+           tries++) {
+        candidates.clear();
+        conflicts->appendNeighbours(removed[uniform(removed.size())],
+                                    candidates);
+        owners.clear();
+        conflicts->appendConflicts(candidates[uniform(candidates.size())],
+                                   owners);
+        if (!owners.empty()) {
+          int owner = owners[uniform(owners.size())];
+          remove(owner);
+          removed.push_back(owner);
+        }
+      }
+    } else {
+      while (static_cast<int>(removed.size()) < removals) {
+        int member = members[uniform(members.size())];
+        remove(member);
+        removed.push_back(member);
+      }
+    }
+
+    // repair: only the neighbours of the removed elements may have become
+    // addable, unless a matroid is outside the index
+    int added = 0;
+    if (conflicts) {
+      candidates.clear();
+      for (int element : removed) {
+        conflicts->appendNeighbours(element, candidates);
+      }
+      std::shuffle(candidates.begin(), candidates.end(), rng);
+      for (int candidate : candidates) {
+        if (position[candidate] == -1 && problem.canAdd(candidate)) {
+          add(candidate);
+          ++added;
+        }
+      }
+    } else {
+      int offset = uniform(edgesCount);
+      for (int i = 0; i < edgesCount; i++) {
+        int candidate = (offset + i) % edgesCount;
+        if (position[candidate] == -1 && problem.canAdd(candidate)) {
+          add(candidate);
+          ++added;
+        }
+      }
+    }
+
+    int delta = added - static_cast<int>(removed.size());
+    if (delta > 0) {
+      problem.commit(checkpoint);
+      ++improvements_;
+    } else if (delta == 0 && acceptance > 0 && coin(rng) < acceptance) {
+      problem.commit(checkpoint);
+      ++plateauMoves_;
+    } else {
+      rollback(checkpoint);
+    }
+    acceptance *= cooling_;
+
+    if (members.size() > best.size()) {
+      best = members;
+      sinceBest = 0;
+    } else if (restartInterval_ > 0 && ++sinceBest >= restartInterval_) {
+      ++restarts_;
+      sinceBest = 0;
+      acceptance = initialAcceptance_;
+      while (!members.empty()) {
+        remove(members.back());
+      }
+      std::shuffle(order.begin(), order.end(), rng);
+      fill();
+    }
+  }
+  elapsedSeconds_ = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+  // leave the best solution in the problem
+  while (!members.empty()) {
+    remove(members.back());
+  }
+  for (int element : best) {
+    add(element);
+  }
+  std::sort(best.begin(), best.end());
+  bool maximal = !conflicts ||
+                 conflicts->getGraphRank() == problem.getMatroidQuantity();
+  return ApproximationSolution(
+      maximal ? 1.0 / problem.getMatroidQuantity() : 0.0, best);
+}
+
+template class BasicBaselineAlgorithm<MatroidProblem>;
+template class BasicBaselineAlgorithm<StaticBipartiteMatchingProblem>;
+template class BasicBaselineAlgorithm<Static3DMatchingProblem>;
+template class BasicBaselineAlgorithm<StaticHamiltonianPathProblem>;
+
+template class BasicLocalSearchAlgorithm<MatroidProblem>;
+template class BasicLocalSearchAlgorithm<StaticBipartiteMatchingProblem>;
+template class BasicLocalSearchAlgorithm<Static3DMatchingProblem>;
+template class BasicLocalSearchAlgorithm<StaticHamiltonianPathProblem>;
+
+template class BasicParallelLocalSearchAlgorithm<MatroidProblem>;
+template class BasicParallelLocalSearchAlgorithm<
+    StaticBipartiteMatchingProblem>;
+template class BasicParallelLocalSearchAlgorithm<Static3DMatchingProblem>;
+template class BasicParallelLocalSearchAlgorithm<StaticHamiltonianPathProblem>;
+
+template class BasicWeightedLocalSearchAlgorithm<MatroidProblem>;
+template class BasicWeightedLocalSearchAlgorithm<
+    StaticBipartiteMatchingProblem>;
+template class BasicWeightedLocalSearchAlgorithm<Static3DMatchingProblem>;
+template class BasicWeightedLocalSearchAlgorithm<StaticHamiltonianPathProblem>;
+
+template class BasicSamplingLocalSearchAlgorithm<MatroidProblem>;
+template class BasicSamplingLocalSearchAlgorithm<
+    StaticBipartiteMatchingProblem>;
+template class BasicSamplingLocalSearchAlgorithm<Static3DMatchingProblem>;
+template class BasicSamplingLocalSearchAlgorithm<StaticHamiltonianPathProblem>;
@@ -1,35 +1,181 @@
 #include "matroid_problem.h"
+#include <stdexcept>
+
+MatroidProblem::MatroidProblem(const MatroidProblem &other)
+    : groundSetSize_(other.groundSetSize_),
+      matroidQuantity_(other.matroidQuantity_),
+      setMembership_(other.setMembership_), counters_(other.counters_),
+      checkOrder_(other.checkOrder_),
+      adaptiveCheckOrder_(other.adaptiveCheckOrder_),
+      members_(other.members_), undoLog_(other.undoLog_),
+      weights_(other.weights_) {
+  for (const auto &matroid : other.matroids_) {
+    matroids_.push_back(matroid->clone());
+  }
+}
 
 bool MatroidProblem::tryAddElement(int element) {
-  int successfulAdditions = 0;
+  // a rejected element costs only reads: nothing to roll back
+  if (!canAdd(element)) {
+    if constexpr (kOracleCountersEnabled) {
+      counters_.rejectedAdditions++;
+    }
+    return false;
+  }
+  addElement(element);
+  return true;
+}
 
+void MatroidProblem::addElement(int element) {
   for (auto &matroid : matroids_) {
     if (!matroid->tryAddElement(element)) {
-      // Rollback: remove element from all previously added matroids
-      for (int i = 0; i < successfulAdditions; i++) {
-        matroids_[i]->removeElement(element);
-      }
-      return false;
+      throw std::logic_error("Element rejected after passing canAdd");
     }
-    successfulAdditions++;
   }
   setMembership_[element] = true;
-  return true;
+  members_.add(element, setMembership_);
+  undoLog_.recordAddition(element);
+  if constexpr (kOracleCountersEnabled) {
+    counters_.additions++;
+  }
+}
+
+bool MatroidProblem::canAdd(int element) const {
+  if (setMembership_[element]) {
+    return false;
+  }
+  return checkOrder().query([this, element](std::size_t i) {
+    return counters_.countCanAdd(i, matroids_[i]->canAdd(element));
+  });
+}
+
+bool MatroidProblem::canExchange(int removed, int added) const {
+  if (!setMembership_[removed] || setMembership_[added]) {
+    return false;
+  }
+  return checkOrder().query([this, removed, added](std::size_t i) {
+    return counters_.countCanExchange(
+        i, matroids_[i]->canExchange(removed, added));
+  });
+}
+
+std::uint32_t MatroidProblem::canAddBatch(const int *elements, int count,
+                                          std::uint32_t mask) const {
+  mask &= count >= 32 ? ~std::uint32_t{0} : (std::uint32_t{1} << count) - 1;
+  for (int i = 0; i < count; i++) {
+    if (setMembership_[elements[i]]) {
+      mask &= ~(std::uint32_t{1} << i);
+    }
+  }
+  if (mask == 0) {
+    return 0;
+  }
+  return checkOrder().queryBatch(
+      mask, [this, elements, count](std::size_t i, std::uint32_t queried) {
+        return counters_.countCanAddBatch(
+            i, count, queried,
+            matroids_[i]->canAddBatch(elements, count, queried));
+      });
+}
+
+std::uint32_t MatroidProblem::MatroidSet::canAddBatch(
+    const int *elements, int count, std::uint32_t mask) const {
+  for (int i = 0; i < count; i++) {
+    if (((mask >> i) & 1) && !canAdd(elements[i])) {
+      mask &= ~(std::uint32_t{1} << i);
+    }
+  }
+  return mask;
+}
+
+void MatroidProblem::MatroidSet::restoreElement(int element) {
+  if (!tryAddElement(element)) {
+    throw std::logic_error("Restored element rejected");
+  }
 }
 
 void MatroidProblem::removeElement(int element) {
   if (!setMembership_[element]) {
     throw std::invalid_argument("Element not in the set");
   }
+  eraseElement(element);
+  members_.remove();
+  undoLog_.recordRemoval(element);
+}
+
+void MatroidProblem::eraseElement(int element) {
   for (auto &matroid : matroids_) {
     matroid->removeElement(element);
   }
   setMembership_[element] = false;
+  if constexpr (kOracleCountersEnabled) {
+    counters_.removals++;
+  }
+}
+
+void MatroidProblem::rollback(std::size_t checkpoint) {
+  undoLog_.rollback(checkpoint, [this](int element, bool wasAdded) {
+    undo(element, wasAdded);
+  });
+}
+
+void MatroidProblem::undo(int element, bool wasAdded) {
+  if (wasAdded) {
+    eraseElement(element);
+    members_.remove();
+    if constexpr (kOracleCountersEnabled) {
+      counters_.undoRemovals++;
+    }
+  } else {
+    for (auto &matroid : matroids_) {
+      matroid->restoreElement(element);
+    }
+    setMembership_[element] = true;
+    members_.add(element, setMembership_);
+    if constexpr (kOracleCountersEnabled) {
+      counters_.additions++;
+      counters_.undoAdditions++;
+    }
+  }
 }
 
 void MatroidProblem::reset() {
-  for (int i = 0; i < groundSetSize_; i++)
-    if (setMembership_[i]) {
-      removeElement(i);
+  undoLog_.clear();
+  // an element added more than once since the last compaction is listed
+  // more than once
+  for (int element : members_.takeAll()) {
+    if (setMembership_[element]) {
+      eraseElement(element);
     }
-}
\ No newline at end of file
+  }
+}
+
+void MatroidProblem::setAdaptiveCheckOrder(bool adaptive) {
+  adaptiveCheckOrder_ = adaptive;
+  checkOrder().setAdaptive(adaptive);
+}
+
+const std::vector<std::size_t> &MatroidProblem::getCheckOrder() const {
+  return checkOrder().getOrder();
+}
+
+MatroidCheckOrder &MatroidProblem::checkOrder() const {
+  if (checkOrder_.size() != matroids_.size()) {
+    std::vector<double> costs;
+    for (const auto &matroid : matroids_) {
+      costs.push_back(matroid->getQueryCost());
+    }
+    checkOrder_ = MatroidCheckOrder(std::move(costs));
+    checkOrder_.setAdaptive(adaptiveCheckOrder_);
+  }
+  return checkOrder_;
+}
+
+std::size_t MatroidProblem::getMemoryBytes() const {
+  std::size_t bytes = getVectorBytes(setMembership_) +
+                      members_.getMemoryBytes() + undoLog_.getMemoryBytes();
+  for (const auto &matroid : matroids_) {
+    bytes += matroid->getMemoryBytes();
+  }
+  return bytes;
+}
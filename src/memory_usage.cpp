@@ -0,0 +1,39 @@
+#include "memory_usage.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+ProcessMemory getProcessMemory() {
+  ProcessMemory memory;
+  // Linux: VmRSS and VmHWM (the peak) in kB
+  std::ifstream status("/proc/self/status");
+  for (std::string line; std::getline(status, line);) {
+    std::istringstream fields(line);
+    std::string key;
+    std::size_t kilobytes = 0;
+    fields >> key >> kilobytes;
+    if (key == "VmRSS:") {
+      memory.currentBytes = kilobytes * 1024;
+    } else if (key == "VmHWM:") {
+      memory.peakBytes = kilobytes * 1024;
+    }
+  }
+#if defined(__unix__) || defined(__APPLE__)
+  if (memory.peakBytes == 0) {
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+      // kB on Linux, bytes on macOS
+#ifdef __APPLE__
+      memory.peakBytes = static_cast<std::size_t>(usage.ru_maxrss);
+#else
+      memory.peakBytes = static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+  }
+#endif
+  return memory;
+}
@@ -0,0 +1,154 @@
+#include "result_writer.h"
+#include <charconv>
+#include <stdexcept>
+
+namespace {
+
+// Buffered writer of the integer arrays of a graph
+class EdgeArrayWriter {
+public:
+  explicit EdgeArrayWriter(std::ostream &out) : out_(out) { put('['); }
+
+  ~EdgeArrayWriter() {
+    put(']');
+    flush();
+  }
+
+  void edge(const int *vertices, int count) {
+    if (!firstEdge_) {
+      put(',');
+    }
+    firstEdge_ = false;
+    put('[');
+    for (int i = 0; i < count; i++) {
+      if (i > 0) {
+        put(',');
+      }
+      if (used_ + kMaxIntLength > sizeof(buffer_)) {
+        flush();
+      }
+      used_ = static_cast<std::size_t>(
+          std::to_chars(buffer_ + used_, buffer_ + sizeof(buffer_),
+                        vertices[i])
+              .ptr -
+          buffer_);
+    }
+    put(']');
+  }
+
+private:
+  static constexpr std::size_t kMaxIntLength = 11;
+
+  void put(char c) {
+    if (used_ == sizeof(buffer_)) {
+      flush();
+    }
+    buffer_[used_++] = c;
+  }
+
+  void flush() {
+    out_.write(buffer_, static_cast<std::streamsize>(used_));
+    used_ = 0;
+  }
+
+  std::ostream &out_;
+  char buffer_[1 << 16];
+  std::size_t used_ = 0;
+  bool firstEdge_ = true;
+};
+
+} // namespace
+
+void writeEdges(std::ostream &out, const HyperedgeList &edges) {
+  EdgeArrayWriter writer(out);
+  std::vector<int> vertices(edges.getRank());
+  for (int i = 0; i < edges.size(); i++) {
+    for (int p = 0; p < edges.getRank(); p++) {
+      vertices[p] = edges.getVertex(i, p);
+    }
+    writer.edge(vertices.data(), edges.getRank());
+  }
+}
+
+void writeEdges(std::ostream &out,
+                const std::vector<std::pair<int, int>> &edges) {
+  EdgeArrayWriter writer(out);
+  for (const auto &[from, to] : edges) {
+    int vertices[2] = {from, to};
+    writer.edge(vertices, 2);
+  }
+}
+
+ResultWriter::ResultWriter(std::ostream &out, Format format,
+                           GraphMode graphMode, std::string instancePath)
+    : out_(out), format_(format), graphMode_(graphMode),
+      instancePath_(std::move(instancePath)) {
+  if (graphMode_ == GraphMode::Reference && instancePath_.empty()) {
+    throw std::invalid_argument("A referenced graph needs an instance file");
+  }
+}
+
+void ResultWriter::begin(const std::string &problemName,
+                         const GraphWriter &writeGraph) {
+  // keys in the alphabetical order nlohmann::json dumps them in
+  out_ << '{';
+  if (graphMode_ == GraphMode::Inline) {
+    out_ << "\"graph\":";
+    writeGraph(out_);
+    out_ << ',';
+  } else if (graphMode_ == GraphMode::Reference) {
+    out_ << "\"instance\":" << nlohmann::json(instancePath_).dump() << ',';
+  }
+  out_ << "\"problem_name\":" << nlohmann::json(problemName).dump();
+  if (format_ == Format::Json) {
+    out_ << ",\"solutions\":[";
+  } else {
+    out_ << ",\"record\":\"problem\"}\n";
+  }
+  out_.flush();
+  open_ = true;
+}
+
+void ResultWriter::addSolution(const nlohmann::json &solution) {
+  if (format_ == Format::Json) {
+    if (!firstSolution_) {
+      out_ << ',';
+    }
+    out_ << solution.dump();
+  } else {
+    nlohmann::json record = solution;
+    record["record"] = "solution";
+    out_ << record.dump() << '\n';
+  }
+  firstSolution_ = false;
+  out_.flush();
+}
+
+void ResultWriter::end(const nlohmann::json &memory) {
+  open_ = false;
+  if (format_ == Format::Json) {
+    out_ << ']';
+    if (!memory.is_null()) {
+      out_ << ",\"memory\":" << memory.dump();
+    }
+    out_ << '}' << std::endl;
+  } else if (!memory.is_null()) {
+    nlohmann::json record = memory;
+    record["record"] = "memory";
+    out_ << record.dump() << std::endl;
+  }
+}
+
+void ResultWriter::fail(const std::string &message) {
+  if (!open_) {
+    return;
+  }
+  open_ = false;
+  if (format_ == Format::Json) {
+    out_ << "],\"error\":" << nlohmann::json(message).dump() << '}'
+         << std::endl;
+  } else {
+    out_ << nlohmann::json{{"error", message}, {"record", "error"}}.dump()
+         << std::endl;
+  }
+}
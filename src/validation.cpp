@@ -1,138 +1,246 @@
 #include "validation.h"
+#include "memory_usage.h"
 #include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
-void check_solution_set(int groundSetSize, const std::vector<int> &solution) {
-  std::vector<int> sorted_solution = solution;
-  std::sort(sorted_solution.begin(), sorted_solution.end());
-  for (int i = 0; i < sorted_solution.size(); i++) {
-    if (i && sorted_solution[i] == sorted_solution[i - 1]) {
-      throw std::invalid_argument(
-          "Solution error: Duplicate element in solution");
+namespace {
+
+// inputs from this size on are checked in parallel chunks
+constexpr int kParallelInputSize = 1 << 20;
+// elements checked between two looks at the failure flag
+constexpr int kCheckBlockSize = 1 << 14;
+
+// Whether check(i) holds for every i in [0, size); a chunk that fails stops
+// the others at their next block
+template <typename Check> bool checkAll(int size, const Check &check) {
+  int threadCount = 1;
+  if (size >= kParallelInputSize) {
+    threadCount = std::max(
+        1, std::min(static_cast<int>(std::thread::hardware_concurrency()),
+                    size / (kParallelInputSize / 4)));
+  }
+  std::atomic<bool> failed{false};
+  auto checkChunk = [&](int begin, int end) {
+    for (int block = begin; block < end; block += kCheckBlockSize) {
+      if (failed.load(std::memory_order_relaxed)) {
+        return;
+      }
+      int blockEnd = std::min(end, block + kCheckBlockSize);
+      for (int i = block; i < blockEnd; i++) {
+        if (!check(i)) {
+          failed = true;
+          return;
+        }
+      }
+    }
+  };
+  if (threadCount == 1) {
+    checkChunk(0, size);
+  } else {
+    std::vector<std::thread> threads;
+    int chunk = (size + threadCount - 1) / threadCount;
+    for (int begin = 0; begin < size; begin += chunk) {
+      threads.emplace_back(checkChunk, begin, std::min(size, begin + chunk));
     }
-    if (sorted_solution[i] < 0 || sorted_solution[i] >= groundSetSize) {
-      throw std::invalid_argument("Solution error: Element out of bounds");
+    for (auto &thread : threads) {
+      thread.join();
     }
   }
+  return !failed;
 }
 
-void validate_bipartite_matching(int n,
-                                 const std::vector<std::pair<int, int>> &edges,
-                                 const std::vector<int> &solution) {
-  for (const auto &edge : edges) {
-    if (edge.first < 0 || edge.first >= n || edge.second < 0 ||
-        edge.second >= n) {
-      throw std::invalid_argument(
-          "Input failed validation: Edge out of bounds");
+// Marks the solution in inSolution, which must be clear and is cleared
+// again before an error is thrown
+void markSolutionSet(std::vector<bool> &inSolution,
+                     const std::vector<int> &solution) {
+  int groundSetSize = static_cast<int>(inSolution.size());
+  const char *error = nullptr;
+  std::size_t marked = 0;
+  for (; marked < solution.size(); marked++) {
+    int element = solution[marked];
+    if (element < 0 || element >= groundSetSize) {
+      error = "Solution error: Element out of bounds";
+      break;
     }
-  }
-  check_solution_set(edges.size(), solution);
-  std::vector<std::vector<bool>> used_vertices(2, std::vector<bool>(n, false));
-  for (int i = 0; i < solution.size(); i++) {
-    if (used_vertices[0][edges[solution[i]].first]) {
-      throw std::invalid_argument("Solution error: Edge already used");
+    if (inSolution[element]) {
+      error = "Solution error: Duplicate element in solution";
+      break;
     }
-    if (used_vertices[1][edges[solution[i]].second]) {
-      throw std::invalid_argument("Solution error: Edge already used");
+    inSolution[element] = true;
+  }
+  if (error) {
+    for (std::size_t i = 0; i < marked; i++) {
+      inSolution[solution[i]] = false;
     }
-    used_vertices[0][edges[solution[i]].first] = true;
-    used_vertices[1][edges[solution[i]].second] = true;
+    throw std::invalid_argument(error);
   }
 }
 
-void validate_3d_matching(int n, const std::vector<std::vector<int>> &edges,
-                          const std::vector<int> &solution) {
-  // Validate edges are within bounds and have correct structure
-  for (const auto &edge : edges) {
-    if (edge.size() != 3) {
+void clearSolutionSet(std::vector<bool> &inSolution,
+                      const std::vector<int> &solution) {
+  for (int element : solution) {
+    inSolution[element] = false;
+  }
+}
+
+} // namespace
+
+MatchingValidator::MatchingValidator(
+    int n, std::shared_ptr<const HyperedgeList> edges, int rank)
+    : n_(n), edges_(std::move(edges)) {
+  if (edges_->getRank() != rank) {
+    throw std::invalid_argument(
+        "Input failed validation: Edge must have exactly " +
+        std::to_string(rank) + " vertices");
+  }
+  for (int p = 0; p < rank; p++) {
+    const int *column = edges_->getColumn(p);
+    if (!checkAll(edges_->size(), [column, n](int i) {
+          return column[i] >= 0 && column[i] < n;
+        })) {
       throw std::invalid_argument(
-          "Input failed validation: Edge must have exactly 3 vertices");
-    }
-    for (int i = 0; i < 3; i++) {
-      if (edge[i] < 0 || edge[i] >= n) {
-        throw std::invalid_argument(
-            "Input failed validation: Edge vertex out of bounds");
-      }
+          rank == 2 ? "Input failed validation: Edge out of bounds"
+                    : "Input failed validation: Edge vertex out of bounds");
     }
   }
-  check_solution_set(edges.size(), solution);
-  // Track used vertices in each of the 3 partitions
-  std::vector<std::vector<bool>> used_vertices(3, std::vector<bool>(n, false));
-  for (int i = 0; i < solution.size(); i++) {
-    const auto &edge = edges[solution[i]];
-    for (int p = 0; p < 3; p++) {
-      if (used_vertices[p][edge[p]]) {
-        throw std::invalid_argument("Solution error: Vertex already used");
+  inSolution_.assign(edges_->size(), false);
+  used_.assign(static_cast<std::size_t>(rank) * n, false);
+}
+
+void MatchingValidator::validate(const std::vector<int> &solution) const {
+  markSolutionSet(inSolution_, solution);
+  int rank = edges_->getRank();
+  // the vertex of partition p is used_[p * n + vertex]; marks all but the
+  // failing solution element's, which are then cleared
+  bool conflict = false;
+  std::size_t marked = 0;
+  for (; marked < solution.size(); marked++) {
+    int element = solution[marked];
+    for (int p = 0; p < rank; p++) {
+      if (used_[p * n_ + edges_->getVertex(element, p)]) {
+        conflict = true;
       }
-      used_vertices[p][edge[p]] = true;
+    }
+    if (conflict) {
+      break;
+    }
+    for (int p = 0; p < rank; p++) {
+      used_[p * n_ + edges_->getVertex(element, p)] = true;
     }
   }
-}
-
-void validate_hamiltonian_path(int n,
-                               const std::vector<std::pair<int, int>> &edges,
-                               const std::vector<int> &solution) {
-  // Validate edges are within bounds
-  for (const auto &edge : edges) {
-    if (edge.first < 0 || edge.first >= n || edge.second < 0 ||
-        edge.second >= n) {
-      throw std::invalid_argument(
-          "Input failed validation: Edge out of bounds");
+  for (std::size_t i = 0; i < marked; i++) {
+    for (int p = 0; p < rank; p++) {
+      used_[p * n_ + edges_->getVertex(solution[i], p)] = false;
     }
   }
-  check_solution_set(edges.size(), solution);
-
-  // Empty solution is valid
-  if (solution.empty()) {
-    return;
+  clearSolutionSet(inSolution_, solution);
+  if (conflict) {
+    throw std::invalid_argument(rank == 2
+                                    ? "Solution error: Edge already used"
+                                    : "Solution error: Vertex already used");
   }
+}
 
-  // Track incoming and outgoing edges for each vertex
-  // Use -1 to indicate no edge
-  std::vector<int> incoming(n, -1); // vertex -> edge index
-  std::vector<int> outgoing(n, -1); // vertex -> edge index
+std::size_t MatchingValidator::getMemoryBytes() const {
+  return getVectorBytes(inSolution_) + getVectorBytes(used_);
+}
 
-  // Build adjacency information and check constraints
-  for (int edge_idx : solution) {
-    const auto &edge = edges[edge_idx];
-    int from_vertex = edge.first;
-    int to_vertex = edge.second;
+HamiltonianPathValidator::HamiltonianPathValidator(
+    int n, std::shared_ptr<const HyperedgeList> edges)
+    : n_(n), edges_(std::move(edges)) {
+  if (edges_->getRank() != 2) {
+    throw std::invalid_argument(
+        "Input failed validation: Edge must have exactly 2 vertices");
+  }
+  from_ = edges_->getColumn(0);
+  to_ = edges_->getColumn(1);
+  if (!checkAll(edges_->size(), [this](int i) {
+        return from_[i] >= 0 && from_[i] < n_ && to_[i] >= 0 && to_[i] < n_;
+      })) {
+    throw std::invalid_argument("Input failed validation: Edge out of bounds");
+  }
+  inSolution_.assign(edges_->size(), false);
+  incoming_.assign(n, -1);
+  outgoing_.assign(n, -1);
+}
 
-    // Check incoming edge constraint (each vertex can have at most one incoming
-    // edge)
-    if (incoming[to_vertex] != -1) {
-      throw std::invalid_argument(
-          "Solution error: Vertex has multiple incoming edges");
+void HamiltonianPathValidator::validate(
+    const std::vector<int> &solution) const {
+  markSolutionSet(inSolution_, solution);
+  const char *error = nullptr;
+  std::size_t marked = 0;
+  for (; marked < solution.size(); marked++) {
+    int from = from_[solution[marked]];
+    int to = to_[solution[marked]];
+    if (incoming_[to] != -1) {
+      error = "Solution error: Vertex has multiple incoming edges";
+      break;
     }
-    incoming[to_vertex] = edge_idx;
-
-    // Check outgoing edge constraint (each vertex can have at most one outgoing
-    // edge)
-    if (outgoing[from_vertex] != -1) {
-      throw std::invalid_argument(
-          "Solution error: Vertex has multiple outgoing edges");
+    if (outgoing_[from] != -1) {
+      error = "Solution error: Vertex has multiple outgoing edges";
+      break;
     }
-    outgoing[from_vertex] = edge_idx;
+    incoming_[to] = solution[marked];
+    outgoing_[from] = solution[marked];
   }
-
-  // Check for cycles
-  std::vector<int> visited(n, 0);
-  int iter = 1;
-  for (int v = 0; v < n; ++v) {
-    if (!visited[v]) {
-      int cur = v;
-      while (outgoing[cur] != -1) {
-        cur = edges[outgoing[cur]].second;
-        if (visited[cur]) {
-          if (visited[cur] == iter) {
-            throw std::invalid_argument("Solution error: Cycle detected");
-          }
-          break;
-        }
-        visited[cur] = iter;
+  // every vertex has at most one edge in and one out, so the solution is a
+  // union of paths and cycles; an edge not reached from a path's start lies
+  // on a cycle
+  if (!error) {
+    std::size_t reached = 0;
+    for (int edge_i : solution) {
+      int cur = from_[edge_i];
+      if (incoming_[cur] != -1) {
+        continue;
+      }
+      while (outgoing_[cur] != -1) {
+        ++reached;
+        cur = to_[outgoing_[cur]];
       }
-      ++iter;
     }
+    if (reached != solution.size()) {
+      error = "Solution error: Cycle detected";
+    }
+  }
+  for (std::size_t i = 0; i < marked; i++) {
+    incoming_[to_[solution[i]]] = -1;
+    outgoing_[from_[solution[i]]] = -1;
+  }
+  clearSolutionSet(inSolution_, solution);
+  if (error) {
+    throw std::invalid_argument(error);
   }
-}
\ No newline at end of file
+}
+
+std::size_t HamiltonianPathValidator::getMemoryBytes() const {
+  return getVectorBytes(inSolution_) + getVectorBytes(incoming_) +
+         getVectorBytes(outgoing_);
+}
+
+void validate_bipartite_matching(int n, const HyperedgeList &edges,
+                                 const std::vector<int> &solution) {
+  // a non-owning pointer: the edges outlive the validator
+  std::shared_ptr<const HyperedgeList> view(std::shared_ptr<const void>(),
+                                            &edges);
+  MatchingValidator(n, view, 2).validate(solution);
+}
+
+void validate_3d_matching(int n, const HyperedgeList &edges,
+                          const std::vector<int> &solution) {
+  std::shared_ptr<const HyperedgeList> view(std::shared_ptr<const void>(),
+                                            &edges);
+  MatchingValidator(n, view, 3).validate(solution);
+}
+
+void validate_hamiltonian_path(int n,
+                               const std::vector<std::pair<int, int>> &edges,
+                               const std::vector<int> &solution) {
+  HamiltonianPathValidator(
+      n, std::make_shared<const HyperedgeList>(HyperedgeList::fromPairs(edges)))
+      .validate(solution);
+}